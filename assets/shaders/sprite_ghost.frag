@@ -0,0 +1,14 @@
+#version 450
+in layout(location = 0) vec2 frag_texcoord;
+
+out layout(location = 0) vec4 out_color;
+
+layout(binding = 0) uniform sampler2D texture_sampler;
+
+// Set to kGhostOpacity when the pipeline is created.
+layout(constant_id = 0) const float opacity = 0.4;
+
+void main() {
+  out_color = texture(texture_sampler, frag_texcoord);
+  out_color.a *= opacity;
+}
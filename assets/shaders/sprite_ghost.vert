@@ -0,0 +1,10 @@
+#version 450 core
+layout(location = 0) in vec4 in_vertex;
+layout(location = 1) in float in_offset;
+
+layout(location = 0) out vec2 frag_texcoord;
+
+void main() {
+  gl_Position = vec4(in_vertex.x, in_vertex.y + in_offset, 0.0f, 1.0f);
+  frag_texcoord = in_vertex.zw;
+}
@@ -0,0 +1,11 @@
+precision mediump float;
+
+varying vec2 frag_texcoord;
+
+uniform sampler2D texture_sampler;
+uniform float opacity;
+
+void main() {
+  gl_FragColor = texture2D(texture_sampler, frag_texcoord);
+  gl_FragColor.a *= opacity;
+}
@@ -0,0 +1,12 @@
+#version 330 core
+in vec2 frag_texcoord;
+
+out vec4 out_color;
+
+uniform sampler2D texture_sampler;
+uniform float opacity;
+
+void main() {
+  out_color = texture(texture_sampler, frag_texcoord);
+  out_color.a *= opacity;
+}
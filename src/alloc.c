@@ -0,0 +1,202 @@
+#include "alloc.h"
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "window.h"
+
+#ifndef NDEBUG
+// Frames allowed to allocate while drivers and libraries warm up.
+static const unsigned int kAllocWarmupFrames = 120;
+#endif
+
+static const char *const kPhaseNames[ALLOC_PHASE_COUNT] = {
+    "load", "input", "simulate", "render", "present", "idle"};
+
+typedef struct AllocCounters {
+  atomic_uint_fast64_t allocations;
+  atomic_uint_fast64_t bytes;
+  atomic_uint_fast64_t frees;
+} AllocCounters;
+
+/**
+ * Per-frame statistics of a phase.
+ */
+typedef struct AllocFrames {
+  uint64_t frames;    // Frames that allocated in this phase
+  uint64_t max_count; // Most allocations in one frame
+  uint64_t max_bytes; // Most bytes in one frame
+} AllocFrames;
+
+static AllocCounters counters[ALLOC_PHASE_COUNT];
+
+#if defined(_MSC_VER)
+static __declspec(thread) AllocPhase current_phase = ALLOC_PHASE_LOAD;
+#else
+static _Thread_local AllocPhase current_phase = ALLOC_PHASE_LOAD;
+#endif
+
+static uint64_t frame_start[ALLOC_PHASE_COUNT][2];
+static AllocFrames frame_stats[ALLOC_PHASE_COUNT];
+static unsigned int frame_count = 0;
+static atomic_int frame_skipped = 0; // Also set by the simulation thread
+
+static void record_allocation(size_t size) {
+  AllocCounters *phase = &counters[current_phase];
+  atomic_fetch_add_explicit(&phase->allocations, 1, memory_order_relaxed);
+  atomic_fetch_add_explicit(&phase->bytes, size, memory_order_relaxed);
+}
+
+static void record_free(void *pointer) {
+  if (pointer != NULL) {
+    atomic_fetch_add_explicit(&counters[current_phase].frees, 1,
+                              memory_order_relaxed);
+  }
+}
+
+#ifdef __GLIBC__
+// Interpose the C library allocator. glibc exports its implementation
+// under these names, so the wrappers need no dlsym and no recursion guard.
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *pointer, size_t size);
+extern void *__libc_memalign(size_t alignment, size_t size);
+extern void __libc_free(void *pointer);
+
+#define real_malloc __libc_malloc
+#define real_realloc __libc_realloc
+#define real_free __libc_free
+
+void *malloc(size_t size) {
+  record_allocation(size);
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+  record_allocation(count * size);
+  return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size) {
+  record_allocation(size);
+  return __libc_realloc(pointer, size);
+}
+
+void *memalign(size_t alignment, size_t size) {
+  record_allocation(size);
+  return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+  record_allocation(size);
+  return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **pointer, size_t alignment, size_t size) {
+  if (alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0) {
+    return EINVAL;
+  }
+  record_allocation(size);
+  void *memory = __libc_memalign(alignment, size);
+  if (memory == NULL) {
+    return ENOMEM;
+  }
+  *pointer = memory;
+  return 0;
+}
+
+void free(void *pointer) {
+  record_free(pointer);
+  __libc_free(pointer);
+}
+#else
+#define real_malloc malloc
+#define real_realloc realloc
+#define real_free free
+#endif
+
+void *alloc_malloc(size_t size) {
+  record_allocation(size);
+  return real_malloc(size);
+}
+
+void *alloc_realloc(void *pointer, size_t size) {
+  record_allocation(size);
+  return real_realloc(pointer, size);
+}
+
+void alloc_free(void *pointer) {
+  record_free(pointer);
+  real_free(pointer);
+}
+
+void alloc_set_phase(AllocPhase phase) { current_phase = phase; }
+
+void alloc_begin_frame(void) {
+  for (int i = 0; i < ALLOC_PHASE_COUNT; i++) {
+    frame_start[i][0] = atomic_load(&counters[i].allocations);
+    frame_start[i][1] = atomic_load(&counters[i].bytes);
+  }
+  frame_skipped = 0;
+  current_phase = ALLOC_PHASE_INPUT;
+}
+
+void alloc_skip_frame(void) { frame_skipped = 1; }
+
+void alloc_end_frame(void) {
+  current_phase = ALLOC_PHASE_IDLE;
+  frame_count++;
+
+  uint64_t counts[ALLOC_PHASE_COUNT];
+  uint64_t bytes[ALLOC_PHASE_COUNT];
+  uint64_t total = 0;
+  for (int i = 0; i < ALLOC_PHASE_COUNT; i++) {
+    counts[i] = atomic_load(&counters[i].allocations) - frame_start[i][0];
+    bytes[i] = atomic_load(&counters[i].bytes) - frame_start[i][1];
+    total += counts[i];
+
+    if (counts[i] > 0) {
+      frame_stats[i].frames++;
+    }
+    if (counts[i] > frame_stats[i].max_count) {
+      frame_stats[i].max_count = counts[i];
+    }
+    if (bytes[i] > frame_stats[i].max_bytes) {
+      frame_stats[i].max_bytes = bytes[i];
+    }
+  }
+
+#ifndef NDEBUG
+  if (total > 0 && !frame_skipped && frame_count > kAllocWarmupFrames) {
+    fprintf(stderr, "Frame %u allocated:", frame_count);
+    for (int i = 0; i < ALLOC_PHASE_COUNT; i++) {
+      if (counts[i] > 0) {
+        fprintf(stderr, " %s %llu (%llu bytes)", kPhaseNames[i],
+                (unsigned long long)counts[i], (unsigned long long)bytes[i]);
+      }
+    }
+    fprintf(stderr, "\n");
+    window_fail_with_error("A steady-state frame allocated memory!");
+  }
+#else
+  (void)total;
+#endif
+}
+
+void alloc_report(void) {
+  printf("Heap allocations over %u frames:\n", frame_count);
+  printf("  %-9s %10s %12s %10s %8s %10s %12s\n", "phase", "allocs", "bytes",
+         "frees", "frames", "max/frame", "max bytes");
+  for (int i = 0; i < ALLOC_PHASE_COUNT; i++) {
+    printf("  %-9s %10llu %12llu %10llu %8llu %10llu %12llu\n", kPhaseNames[i],
+           (unsigned long long)atomic_load(&counters[i].allocations),
+           (unsigned long long)atomic_load(&counters[i].bytes),
+           (unsigned long long)atomic_load(&counters[i].frees),
+           (unsigned long long)frame_stats[i].frames,
+           (unsigned long long)frame_stats[i].max_count,
+           (unsigned long long)frame_stats[i].max_bytes);
+  }
+}
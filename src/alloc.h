@@ -0,0 +1,68 @@
+#ifndef FLAP_ALLOC_H
+#define FLAP_ALLOC_H
+
+#include <stddef.h>
+
+/**
+ * What the calling thread is doing, to attribute heap allocations.
+ */
+typedef enum {
+  ALLOC_PHASE_LOAD,     // Before the first frame
+  ALLOC_PHASE_INPUT,    // Polling window events
+  ALLOC_PHASE_SIMULATE, // Game updates, on either thread
+  ALLOC_PHASE_RENDER,   // Drawing and submitting
+  ALLOC_PHASE_PRESENT,  // Handing the frame to the display
+  ALLOC_PHASE_IDLE,     // Between frames, and shutting down
+  ALLOC_PHASE_COUNT
+} AllocPhase;
+
+#ifdef FLAP_TRACK_ALLOCATIONS
+
+/**
+ * Heap allocation tracking.
+ * Built with FLAP_TRACK_ALLOCATIONS, malloc and friends are interposed
+ * where the C library allows it (glibc), which also catches allocations
+ * made by drivers and libraries. Arena blocks, which hold stb_image
+ * buffers, are tracked everywhere through `alloc_malloc`.
+ * Allocations are counted per phase and per frame.
+ * In debug builds, a steady-state frame that allocates is fatal.
+ */
+void alloc_set_phase(AllocPhase phase);
+
+/**
+ * Start counting a frame. The phase becomes input.
+ */
+void alloc_begin_frame(void);
+
+/**
+ * This frame may allocate, for example to resize the swapchain.
+ * Can be called from any thread.
+ */
+void alloc_skip_frame(void);
+
+/**
+ * Finish counting a frame. The phase becomes idle.
+ */
+void alloc_end_frame(void);
+
+/**
+ * Print allocation counts per phase to stdout.
+ */
+void alloc_report(void);
+
+// Counted allocation functions for libraries that take custom ones.
+void *alloc_malloc(size_t size);
+void *alloc_realloc(void *pointer, size_t size);
+void alloc_free(void *pointer);
+
+#else
+
+static inline void alloc_set_phase(AllocPhase phase) { (void)phase; }
+static inline void alloc_begin_frame(void) {}
+static inline void alloc_skip_frame(void) {}
+static inline void alloc_end_frame(void) {}
+static inline void alloc_report(void) {}
+
+#endif // FLAP_TRACK_ALLOCATIONS
+
+#endif // FLAP_ALLOC_H
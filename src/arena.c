@@ -0,0 +1,147 @@
+#include "arena.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+
+// Blocks come from the counted allocator when tracking allocations,
+// which covers platforms where malloc cannot be interposed.
+#ifdef FLAP_TRACK_ALLOCATIONS
+#define block_malloc alloc_malloc
+#define block_free alloc_free
+#else
+#define block_malloc malloc
+#define block_free free
+#endif
+
+static const size_t kArenaAlignment = _Alignof(max_align_t);
+
+struct ArenaBlock {
+  ArenaBlock *next;
+  size_t size;
+  size_t used;
+  max_align_t data[];
+};
+
+/**
+ * Round `size` up to the alignment. Return 0 on overflow.
+ */
+static size_t align_size(size_t size) {
+  if (size > SIZE_MAX - kArenaAlignment) {
+    return 0;
+  }
+  return (size + kArenaAlignment - 1) & ~(kArenaAlignment - 1);
+}
+
+static ArenaBlock *add_block(Arena *arena, size_t size) {
+  const size_t capacity = size > arena->block_size ? size : arena->block_size;
+  if (capacity > SIZE_MAX - sizeof(ArenaBlock)) {
+    return NULL;
+  }
+
+  ArenaBlock *block = block_malloc(sizeof(ArenaBlock) + capacity);
+  if (block == NULL) {
+    return NULL;
+  }
+
+  block->next = arena->blocks;
+  block->size = capacity;
+  block->used = 0;
+  arena->blocks = block;
+  return block;
+}
+
+static void add_used(Arena *arena, size_t size) {
+  arena->used += size;
+  if (arena->used > arena->peak) {
+    arena->peak = arena->used;
+  }
+}
+
+void arena_init(Arena *arena, size_t block_size) {
+  memset(arena, 0, sizeof(*arena));
+  arena->block_size = align_size(block_size);
+}
+
+void *arena_alloc(Arena *arena, size_t size) {
+  const size_t aligned = align_size(size);
+  if (aligned == 0 && size != 0) {
+    return NULL;
+  }
+
+  ArenaBlock *block = arena->blocks;
+  if (block == NULL || block->size - block->used < aligned) {
+    block = add_block(arena, aligned);
+    if (block == NULL) {
+      return NULL;
+    }
+  }
+
+  void *pointer = (char *)block->data + block->used;
+  block->used += aligned;
+  add_used(arena, aligned);
+
+  arena->last = pointer;
+  return pointer;
+}
+
+void *arena_realloc(Arena *arena, void *pointer, size_t old_size,
+                    size_t size) {
+  if (pointer == NULL) {
+    return arena_alloc(arena, size);
+  }
+
+  if (pointer == arena->last) {
+    ArenaBlock *block = arena->blocks;
+    const size_t start = (size_t)((char *)pointer - (char *)block->data);
+    const size_t aligned = align_size(size);
+    if ((aligned != 0 || size == 0) && aligned <= block->size - start) {
+      arena->used -= block->used - start;
+      block->used = start + aligned;
+      add_used(arena, aligned);
+      return pointer;
+    }
+  }
+
+  void *moved = arena_alloc(arena, size);
+  if (moved != NULL) {
+    memcpy(moved, pointer, old_size < size ? old_size : size);
+  }
+  return moved;
+}
+
+void arena_free(Arena *arena, void *pointer) {
+  if (pointer == NULL || pointer != arena->last) {
+    return;
+  }
+
+  ArenaBlock *block = arena->blocks;
+  const size_t start = (size_t)((char *)pointer - (char *)block->data);
+  arena->used -= block->used - start;
+  block->used = start;
+  arena->last = NULL;
+}
+
+void arena_reset(Arena *arena) {
+  ArenaBlock *block = arena->blocks;
+  while (block != NULL && block->next != NULL) {
+    ArenaBlock *next = block->next;
+    block_free(block);
+    block = next;
+  }
+
+  if (block != NULL) {
+    block->used = 0;
+  }
+  arena->blocks = block;
+  arena->last = NULL;
+  arena->used = 0;
+}
+
+void arena_destroy(Arena *arena) {
+  arena_reset(arena);
+  block_free(arena->blocks);
+  arena->blocks = NULL;
+}
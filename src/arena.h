@@ -0,0 +1,48 @@
+#ifndef FLAP_ARENA_H
+#define FLAP_ARENA_H
+
+#include <stddef.h>
+
+typedef struct ArenaBlock ArenaBlock;
+
+/**
+ * Linear allocator for scratch memory, such as asset files and decode
+ * buffers that only live while loading.
+ * Allocating bumps a pointer, single allocations are never freed and
+ * everything goes at once on reset. Blocks are added as needed.
+ */
+typedef struct Arena {
+  ArenaBlock *blocks; // Newest first
+  size_t block_size;  // Default capacity of a new block
+  void *last;         // Latest allocation, which can grow in place
+  size_t used;        // Bytes handed out since the last reset
+  size_t peak;        // Most bytes handed out between resets
+} Arena;
+
+void arena_init(Arena *arena, size_t block_size);
+
+/**
+ * Return `size` bytes aligned for any type, or NULL if out of memory.
+ */
+void *arena_alloc(Arena *arena, size_t size);
+
+/**
+ * Resize an allocation of `old_size` bytes. The latest allocation grows
+ * in place when its block has room, others are copied.
+ */
+void *arena_realloc(Arena *arena, void *pointer, size_t old_size,
+                    size_t size);
+
+/**
+ * Give back the latest allocation if it is `pointer`, otherwise nothing.
+ */
+void arena_free(Arena *arena, void *pointer);
+
+/**
+ * Free every allocation. Only the first block is kept for reuse.
+ */
+void arena_reset(Arena *arena);
+
+void arena_destroy(Arena *arena);
+
+#endif // FLAP_ARENA_H
@@ -4,21 +4,35 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include "window.h"
-
-/**
- * Read contents of `file_path` using standard C calls.
- * You are responsible for freeing the allocated memory.
- */
-char *assets_base_read_file(const char *file_path, size_t *data_size) {
-  char full_path[64] = {'a', 's', 's', 'e', 't', 's', '/'};
-
 #ifdef _WIN32
-  strncat_s(full_path, 64, file_path, 56);
+#include <io.h>
+#include <windows.h>
 #else
-  strncat(full_path, file_path, 56);
+#include <unistd.h>
 #endif
 
+#include "window.h"
+
+// Where stb_image allocates while `assets_load_image` runs.
+static Arena *image_arena = NULL;
+
+// The one copy of stb_image shared by every backend.
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ASSERT(x)
+#define STBI_NO_STDIO
+#define STBI_ONLY_PNG
+#define STBI_MALLOC(size) arena_alloc(image_arena, size)
+#define STBI_REALLOC_SIZED(pointer, old_size, size)                            \
+  arena_realloc(image_arena, pointer, old_size, size)
+#define STBI_FREE(pointer) arena_free(image_arena, pointer)
+#include "stb_image.h"
+
+/**
+ * Read the whole of `full_path`.
+ * Return NULL without reporting an error if the file cannot be read.
+ */
+static char *read_file_contents(Arena *arena, const char *full_path,
+                                size_t *data_size) {
   FILE *file = NULL;
 
 #ifdef _WIN32
@@ -28,27 +42,55 @@ char *assets_base_read_file(const char *file_path, size_t *data_size) {
 #endif
 
   if (file == NULL) {
-    window_fail_with_error("Assets: Could not open file");
     return NULL;
   }
 
   fseek(file, 0, SEEK_END);
-  const size_t size = (size_t)ftell(file);
+  const long size = ftell(file);
+  if (size <= 0) {
+    fclose(file);
+    return NULL;
+  }
 
-  char *data = NULL;
-  data = (char *)malloc(size * sizeof(char));
+  char *data = (char *)arena_alloc(arena, (size_t)size * sizeof(char));
   if (data == NULL) {
-    window_fail_with_error("Assets: Could not read file contents");
+    fclose(file);
     return NULL;
   }
 
   rewind(file);
-  fread(data, size, 1, file);
+  if (fread(data, (size_t)size, 1, file) != 1) {
+    arena_free(arena, data);
+    fclose(file);
+    return NULL;
+  }
 
   fclose(file);
 
   if (data_size != NULL) {
-    *data_size = size;
+    *data_size = (size_t)size;
+  }
+
+  return data;
+}
+
+/**
+ * Read contents of `file_path` into `arena` using standard C calls.
+ */
+char *assets_base_read_file(Arena *arena, const char *file_path,
+                            size_t *data_size) {
+  char full_path[64] = {'a', 's', 's', 'e', 't', 's', '/'};
+
+#ifdef _WIN32
+  strncat_s(full_path, 64, file_path, 56);
+#else
+  strncat(full_path, file_path, 56);
+#endif
+
+  char *data = read_file_contents(arena, full_path, data_size);
+  if (data == NULL) {
+    window_fail_with_error("Assets: Could not open file");
+    return NULL;
   }
 
   return data;
@@ -69,3 +111,82 @@ void assets_base_write_file(const char *data, size_t data_size,
 
   fclose(file);
 }
+
+/**
+ * Read a cache file written by `assets_base_write_cache`.
+ * A missing or unreadable cache is not an error: NULL is returned.
+ */
+char *assets_base_read_cache(Arena *arena, const char *file_path,
+                             size_t *data_size) {
+  return read_file_contents(arena, file_path, data_size);
+}
+
+/**
+ * Atomically replace `file_path` with `data`.
+ * The data is written to a temporary file which is then renamed
+ * so that a crash never leaves a truncated cache behind.
+ * Return 0 on success.
+ */
+int assets_base_write_cache(const char *data, size_t data_size,
+                            const char *file_path) {
+  char tmp_path[256] = {0};
+  if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", file_path) >=
+      (int)sizeof(tmp_path)) {
+    return -1;
+  }
+
+#ifdef _WIN32
+  FILE *file = NULL;
+  fopen_s(&file, tmp_path, "wb");
+#else
+  FILE *file = fopen(tmp_path, "wbe");
+#endif
+
+  if (file == NULL) {
+    return -1;
+  }
+
+  int ok = fwrite(data, data_size, 1, file) == 1 && fflush(file) == 0;
+
+#ifdef _WIN32
+  ok = ok && _commit(_fileno(file)) == 0;
+#else
+  ok = ok && fsync(fileno(file)) == 0;
+#endif
+
+  ok = fclose(file) == 0 && ok;
+
+  if (!ok) {
+    remove(tmp_path);
+    return -1;
+  }
+
+#ifdef _WIN32
+  if (!MoveFileExA(tmp_path, file_path, MOVEFILE_REPLACE_EXISTING)) {
+#else
+  if (rename(tmp_path, file_path) != 0) {
+#endif
+    remove(tmp_path);
+    return -1;
+  }
+
+  return 0;
+}
+
+unsigned char *assets_load_image(Arena *arena, const char *file_path,
+                                 int *width, int *height) {
+  size_t data_size = 0;
+  char *data = assets_read_file(arena, file_path, &data_size);
+  if (data == NULL) {
+    return NULL;
+  }
+
+  image_arena = arena;
+  int num_channels = 0;
+  stbi_uc *pixels =
+      stbi_load_from_memory((const stbi_uc *)data, (int)data_size, width,
+                            height, &num_channels, STBI_rgb_alpha);
+  image_arena = NULL;
+
+  return pixels;
+}
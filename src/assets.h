@@ -3,14 +3,50 @@
 
 #include <stddef.h>
 
-char *assets_base_read_file(const char *file_path, size_t *data_size);
+#include "arena.h"
+
+// Block size of the arenas that assets are loaded into.
+#define FLAP_ASSETS_ARENA_SIZE (256 * 1024)
+
+char *assets_base_read_file(Arena *arena, const char *file_path,
+                            size_t *data_size);
 
 void assets_base_write_file(const char *data, size_t data_size,
                             const char *file_path);
 
-char *assets_read_file(const char *file_path, size_t *data_size);
+char *assets_base_read_cache(Arena *arena, const char *file_path,
+                             size_t *data_size);
+
+int assets_base_write_cache(const char *data, size_t data_size,
+                            const char *file_path);
+
+/**
+ * Read an asset into `arena`.
+ */
+char *assets_read_file(Arena *arena, const char *file_path, size_t *data_size);
 
 void assets_write_file(const char *data, size_t data_size,
                        const char *file_path);
 
+/**
+ * Read a cache file from the writable data directory into `arena`.
+ * Return NULL if there is no usable cache.
+ */
+char *assets_read_cache(Arena *arena, const char *file_path,
+                        size_t *data_size);
+
+/**
+ * Atomically write a cache file to the writable data directory.
+ * Return 0 on success.
+ */
+int assets_write_cache(const char *data, size_t data_size,
+                       const char *file_path);
+
+/**
+ * Decode the PNG image `file_path` to RGBA pixels in `arena`.
+ * Return NULL if it cannot be read or decoded.
+ */
+unsigned char *assets_load_image(Arena *arena, const char *file_path,
+                                 int *width, int *height);
+
 #endif // FLAP_ASSETS_H
@@ -1,10 +1,12 @@
 #include "assets.h"
 #include "window_android.h"
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-char *assets_read_file(const char *file_path, size_t *data_size) {
+char *assets_read_file(Arena *arena, const char *file_path,
+                       size_t *data_size) {
   struct android_app *app = android_window_get_app();
 
   // Try reading from:
@@ -20,7 +22,11 @@ char *assets_read_file(const char *file_path, size_t *data_size) {
   if (asset != NULL) {
     size_t size = (size_t)AAsset_getLength(asset);
 
-    char *data = (char *)malloc(size * sizeof(char));
+    char *data = (char *)arena_alloc(arena, size * sizeof(char));
+    if (data == NULL) {
+      AAsset_close(asset);
+      return NULL;
+    }
 
     AAsset_read(asset, data, size);
 
@@ -38,7 +44,7 @@ char *assets_read_file(const char *file_path, size_t *data_size) {
   strncat(full_path, app->activity->internalDataPath, max_len);
   strncat(full_path, file_path, max_len - dir_len);
 
-  char *data = assets_base_read_file(full_path, data_size);
+  char *data = assets_base_read_file(arena, full_path, data_size);
   if (data != NULL) {
     return data;
   }
@@ -49,7 +55,7 @@ char *assets_read_file(const char *file_path, size_t *data_size) {
   strncat(full_path, app->activity->externalDataPath, max_len);
   strncat(full_path, file_path, max_len - dir_len);
 
-  data = assets_base_read_file(full_path, data_size);
+  data = assets_base_read_file(arena, full_path, data_size);
   if (data != NULL) {
     return data;
   }
@@ -72,3 +78,25 @@ void assets_write_file(const char *data, size_t data_size,
 
   assets_base_write_file(data, data_size, full_path);
 }
+
+char *assets_read_cache(Arena *arena, const char *file_path,
+                        size_t *data_size) {
+  struct android_app *app = android_window_get_app();
+
+  char full_path[256] = {0};
+  snprintf(full_path, sizeof(full_path), "%s/%s",
+           app->activity->internalDataPath, file_path);
+
+  return assets_base_read_cache(arena, full_path, data_size);
+}
+
+int assets_write_cache(const char *data, size_t data_size,
+                       const char *file_path) {
+  struct android_app *app = android_window_get_app();
+
+  char full_path[256] = {0};
+  snprintf(full_path, sizeof(full_path), "%s/%s",
+           app->activity->internalDataPath, file_path);
+
+  return assets_base_write_cache(data, data_size, full_path);
+}
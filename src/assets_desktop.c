@@ -4,11 +4,22 @@
 #include <stdlib.h>
 #include <string.h>
 
-char *assets_read_file(const char *file_path, size_t *data_size) {
-  return assets_base_read_file(file_path, data_size);
+char *assets_read_file(Arena *arena, const char *file_path,
+                       size_t *data_size) {
+  return assets_base_read_file(arena, file_path, data_size);
 }
 
 void assets_write_file(const char *data, size_t data_size,
                        const char *file_path) {
   assets_base_write_file(data, data_size, file_path);
 }
+
+char *assets_read_cache(Arena *arena, const char *file_path,
+                        size_t *data_size) {
+  return assets_base_read_cache(arena, file_path, data_size);
+}
+
+int assets_write_cache(const char *data, size_t data_size,
+                       const char *file_path) {
+  return assets_base_write_cache(data, data_size, file_path);
+}
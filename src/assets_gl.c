@@ -1,22 +1,46 @@
 #include "assets_gl.h"
 
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "window.h"
 
-#define STB_IMAGE_IMPLEMENTATION
-#define STBI_ASSERT(x)
-#define STBI_NO_STDIO
-#define STBI_ONLY_PNG
-#include "stb_image.h"
+// Identifies program binary cache files.
+static const uint32_t kProgramBinaryMagic = 0x42504c46; // "FLPB"
+
+/**
+ * Program binary cache file header.
+ */
+typedef struct ProgramBinaryHeader {
+  uint32_t magic;
+  uint32_t format; // GLenum returned by glGetProgramBinary
+  uint64_t key;    // Hash of the driver strings and shader sources
+} ProgramBinaryHeader;
+
+/**
+ * 64-bit FNV-1a hash, chained through `hash`.
+ */
+static uint64_t hash_bytes(uint64_t hash, const char *data, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    hash ^= (unsigned char)data[i];
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
 
-GLuint assets_gl_create_shader(GLenum type, const char *file_path) {
-  GLuint id = glCreateShader(type);
+static uint64_t hash_string(uint64_t hash, const GLubyte *str) {
+  if (str == NULL) {
+    return hash;
+  }
+  return hash_bytes(hash, (const char *)str, strlen((const char *)str) + 1);
+}
 
-  size_t size = 0;
-  const GLchar *shader_source = assets_read_file(file_path, &size);
+static GLuint compile_shader(GLenum type, const GLchar *shader_source,
+                             GLint length) {
+  GLuint id = glCreateShader(type);
 
-  const GLint length = (GLint)size;
   glShaderSource(id, 1, &shader_source, &length);
 
   glCompileShader(id);
@@ -39,6 +63,14 @@ GLuint assets_gl_create_shader(GLenum type, const char *file_path) {
   return id;
 }
 
+GLuint assets_gl_create_shader(Arena *arena, GLenum type,
+                               const char *file_path) {
+  size_t size = 0;
+  GLchar *shader_source = assets_read_file(arena, file_path, &size);
+
+  return compile_shader(type, shader_source, (GLint)size);
+}
+
 void assets_gl_check_program(GLuint program) {
   GLint status;
   glGetProgramiv(program, GL_LINK_STATUS, &status);
@@ -47,7 +79,138 @@ void assets_gl_check_program(GLuint program) {
   }
 }
 
-GLuint assets_gl_create_texture(const char *file_path) {
+/**
+ * Whether the context can save and load program binaries:
+ * GL 4.1, GL ES 3.0 or ARB_get_program_binary.
+ */
+static int program_binary_supported(void) {
+  if (!glad_glGetProgramBinary || !glad_glProgramBinary ||
+      !glad_glProgramParameteri) {
+    return 0;
+  }
+
+  GLint num_formats = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+  return num_formats > 0;
+}
+
+/**
+ * Try to restore `program` from the binary cache.
+ * Return GL_TRUE if the driver accepted the cached binary.
+ */
+static GLboolean load_program_binary(Arena *arena, GLuint program,
+                                     const char *file_path, uint64_t key) {
+  size_t data_size = 0;
+  char *data = assets_read_cache(arena, file_path, &data_size);
+  if (data == NULL) {
+    return GL_FALSE;
+  }
+
+  ProgramBinaryHeader header = {0};
+  GLboolean loaded = GL_FALSE;
+
+  if (data_size > sizeof(header)) {
+    memcpy(&header, data, sizeof(header));
+  }
+
+  if (header.magic == kProgramBinaryMagic && header.key == key) {
+    glProgramBinary(program, header.format, data + sizeof(header),
+                    (GLsizei)(data_size - sizeof(header)));
+
+    // A driver update may reject an old binary.
+    GLint status = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    loaded = status == GL_TRUE;
+  }
+
+  return loaded;
+}
+
+static void save_program_binary(Arena *arena, GLuint program,
+                                const char *file_path, uint64_t key) {
+  GLint length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0) {
+    return;
+  }
+
+  const size_t data_size = sizeof(ProgramBinaryHeader) + (size_t)length;
+  char *data = arena_alloc(arena, data_size * sizeof(char));
+  if (data == NULL) {
+    return;
+  }
+
+  ProgramBinaryHeader header = {0};
+  header.magic = kProgramBinaryMagic;
+  header.key = key;
+
+  GLenum format = 0;
+  glGetProgramBinary(program, length, &length, &format,
+                     data + sizeof(header));
+  header.format = format;
+
+  memcpy(data, &header, sizeof(header));
+
+  assets_write_cache(data, sizeof(header) + (size_t)length, file_path);
+}
+
+GLuint assets_gl_create_program(Arena *arena, const char *name,
+                                const char *vertex_shader_path,
+                                const char *fragment_shader_path) {
+  size_t vertex_size = 0;
+  GLchar *vertex_source =
+      assets_read_file(arena, vertex_shader_path, &vertex_size);
+
+  size_t fragment_size = 0;
+  GLchar *fragment_source =
+      assets_read_file(arena, fragment_shader_path, &fragment_size);
+
+  GLuint program = glCreateProgram();
+
+  const int use_binary = program_binary_supported();
+
+  uint64_t key = 0xcbf29ce484222325ULL;
+  key = hash_string(key, glGetString(GL_VENDOR));
+  key = hash_string(key, glGetString(GL_RENDERER));
+  key = hash_string(key, glGetString(GL_VERSION));
+  key = hash_bytes(key, vertex_source, vertex_size);
+  key = hash_bytes(key, fragment_source, fragment_size);
+
+  char file_path[64] = {0};
+  snprintf(file_path, sizeof(file_path), "%s_program.bin", name);
+
+  if (!use_binary || !load_program_binary(arena, program, file_path, key)) {
+    // Fall back to compiling from source.
+    GLuint vertex_shader =
+        compile_shader(GL_VERTEX_SHADER, vertex_source, (GLint)vertex_size);
+    GLuint fragment_shader = compile_shader(
+        GL_FRAGMENT_SHADER, fragment_source, (GLint)fragment_size);
+
+    glAttachShader(program, vertex_shader);
+    glAttachShader(program, fragment_shader);
+
+    if (use_binary) {
+      glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                          GL_TRUE);
+    }
+
+    glLinkProgram(program);
+    assets_gl_check_program(program);
+
+    glDetachShader(program, vertex_shader);
+    glDetachShader(program, fragment_shader);
+    glDeleteShader(vertex_shader);
+    glDeleteShader(fragment_shader);
+
+    if (use_binary) {
+      save_program_binary(arena, program, file_path, key);
+    }
+  }
+
+  return program;
+}
+
+GLuint assets_gl_create_texture(Arena *arena, const char *file_path) {
   GLuint id = 0;
   glGenTextures(1, &id);
   glBindTexture(GL_TEXTURE_2D, id);
@@ -58,15 +221,8 @@ GLuint assets_gl_create_texture(const char *file_path) {
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-  size_t data_size;
-  char *data = NULL;
-  data = assets_read_file(file_path, &data_size);
-
   int width = 0, height = 0;
-  int num_channels = 0;
-  stbi_uc *pixels =
-      stbi_load_from_memory((const stbi_uc *)data, data_size, &width, &height,
-                            &num_channels, STBI_rgb_alpha);
+  unsigned char *pixels = assets_load_image(arena, file_path, &width, &height);
   if (pixels == NULL) {
     window_fail_with_error("Error loading image!");
   }
@@ -74,7 +230,5 @@ GLuint assets_gl_create_texture(const char *file_path) {
   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
                GL_UNSIGNED_BYTE, pixels);
 
-  stbi_image_free(pixels);
-
   return id;
 }
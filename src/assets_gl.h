@@ -2,8 +2,19 @@
 #include "assets.h"
 #include <glad/glad.h>
 
-GLuint assets_gl_create_shader(GLenum type, const char *file_path);
+GLuint assets_gl_create_shader(Arena *arena, GLenum type,
+                               const char *file_path);
 
 void assets_gl_check_program(GLuint program);
 
-GLuint assets_gl_create_texture(const char *file_path);
+/**
+ * Create a program from a vertex and a fragment shader.
+ * The linked binary is cached as `<name>_program.bin` when the driver
+ * supports program binaries and reused as long as the driver and the
+ * shader sources stay the same. Sources and binaries are read into `arena`.
+ */
+GLuint assets_gl_create_program(Arena *arena, const char *name,
+                                const char *vertex_shader_path,
+                                const char *fragment_shader_path);
+
+GLuint assets_gl_create_texture(Arena *arena, const char *file_path);
@@ -0,0 +1,16 @@
+#include "assets_sw.h"
+
+#include "window.h"
+
+void assets_sw_create_texture(Arena *arena, const char *file_path,
+                              RasterTexture *texture) {
+  int width = 0, height = 0;
+  unsigned char *pixels = assets_load_image(arena, file_path, &width, &height);
+  if (pixels == NULL) {
+    window_fail_with_error("Error loading image!");
+  }
+
+  if (raster_texture_init(texture, pixels, width, height) != 0) {
+    window_fail_with_error("Out of memory loading image!");
+  }
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include "assets.h"
+#include "raster.h"
+
+/**
+ * Load an image into a texture for the CPU rasterizer.
+ * Decoding uses `arena`, the texture has its own memory.
+ */
+void assets_sw_create_texture(Arena *arena, const char *file_path,
+                              RasterTexture *texture);
@@ -1,43 +1,106 @@
 #include "assets_vk.h"
 
-#define STB_IMAGE_IMPLEMENTATION
-#define STBI_ASSERT(x)
-#define STBI_NO_STDIO
-#define STBI_ONLY_PNG
-#include "stb_image.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 /**
  * Read SPIR-V code from `file_path`.
  */
-VkResult assets_vk_create_shader(SulfurDevice *dev, const char *file_path,
+VkResult assets_vk_create_shader(SulfurDevice *dev, Arena *arena,
+                                 const char *file_path,
                                  VkShaderStageFlags shader_stage,
                                  SulfurShader *shader) {
   size_t shader_code_size = 0;
-  char *shader_code = assets_read_file(file_path, &shader_code_size);
+  char *shader_code = assets_read_file(arena, file_path, &shader_code_size);
   if (shader_code == NULL) {
     return -1;
   }
 
-  VkResult result = sulfur_shader_create(dev, shader_code, shader_code_size,
-                                         shader_stage, shader);
+  return sulfur_shader_create(dev, shader_code, shader_code_size, shader_stage,
+                              shader);
+}
 
-  free(shader_code);
+// Size of `VkPipelineCacheHeaderVersionOne` as laid out in the cache blob.
+static const size_t kPipelineCacheHeaderSize = 32;
 
-  return result;
+// Cache data when it was last written to disk, or loaded from it.
+static size_t pipeline_cache_saved_size = 0;
+static uint64_t pipeline_cache_saved_hash = 0;
+
+/**
+ * 64-bit FNV-1a hash.
+ */
+static uint64_t hash_bytes(const char *data, size_t size) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= (unsigned char)data[i];
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+static uint32_t read_u32_le(const unsigned char *bytes) {
+  return (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 |
+         (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
 }
 
 /**
- * Read pipeline cache data from `file_path`.
+ * Build the per-device cache file name `<name>_<vendor>_<device>.bin`
+ * so that several GPUs never overwrite each other's cache.
  */
-VkResult assets_vk_create_pipeline_cache(SulfurDevice *dev,
-                                         const char *file_path,
+static void get_pipeline_cache_path(const VkPhysicalDeviceProperties *props,
+                                    const char *name, char *path,
+                                    size_t path_size) {
+  snprintf(path, path_size, "%s_%04x_%04x.bin", name, props->vendorID,
+           props->deviceID);
+}
+
+/**
+ * Check that `data` was produced by this exact device and driver.
+ * Drivers are supposed to reject foreign data themselves
+ * but some of them crash on it instead.
+ */
+static int validate_pipeline_cache(const VkPhysicalDeviceProperties *props,
+                                   const char *data, size_t data_size) {
+  const unsigned char *bytes = (const unsigned char *)data;
+
+  if (data == NULL || data_size < kPipelineCacheHeaderSize) {
+    return 0;
+  }
+
+  const uint32_t header_size = read_u32_le(&bytes[0]);
+  const uint32_t header_version = read_u32_le(&bytes[4]);
+  const uint32_t vendor_id = read_u32_le(&bytes[8]);
+  const uint32_t device_id = read_u32_le(&bytes[12]);
+
+  return header_size >= kPipelineCacheHeaderSize &&
+         header_size <= data_size &&
+         header_version == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+         vendor_id == props->vendorID && device_id == props->deviceID &&
+         memcmp(&bytes[16], props->pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+/**
+ * Read pipeline cache data for the current device from `name`.
+ * A missing, stale or corrupted cache yields an empty pipeline cache.
+ */
+VkResult assets_vk_create_pipeline_cache(SulfurDevice *dev, Arena *arena,
+                                         const char *name,
                                          VkPipelineCache *pipeline_cache) {
-  char *initial_data = NULL;
+  VkPhysicalDeviceProperties props = {0};
+  vkGetPhysicalDeviceProperties(dev->physical_device, &props);
+
+  char file_path[128] = {0};
+  get_pipeline_cache_path(&props, name, file_path, sizeof(file_path));
+
   size_t initial_data_size = 0;
-  initial_data = assets_read_file(file_path, &initial_data_size);
+  char *initial_data = assets_read_cache(arena, file_path, &initial_data_size);
 
-  // It is OK for `initial_data` to be NULL
-  // since we would create an empty cache.
+  if (!validate_pipeline_cache(&props, initial_data, initial_data_size)) {
+    initial_data = NULL;
+    initial_data_size = 0;
+  }
 
   VkPipelineCacheCreateInfo cache_info = {0};
   cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
@@ -49,56 +112,99 @@ VkResult assets_vk_create_pipeline_cache(SulfurDevice *dev,
   VkResult result =
       vkCreatePipelineCache(dev->device, &cache_info, NULL, pipeline_cache);
 
-  free(initial_data);
+  if (result != VK_SUCCESS && initial_data != NULL) {
+    // Retry with an empty cache.
+    cache_info.initialDataSize = 0;
+    cache_info.pInitialData = NULL;
+    result =
+        vkCreatePipelineCache(dev->device, &cache_info, NULL, pipeline_cache);
+    initial_data = NULL;
+    initial_data_size = 0;
+  }
+
+  pipeline_cache_saved_size = initial_data_size;
+  pipeline_cache_saved_hash = hash_bytes(initial_data, initial_data_size);
 
   return result;
 }
 
 /**
- * Write pipeline cache data to `file_path`.
+ * Write pipeline cache data for the current device to `name`
+ * if it changed since it was last saved.
+ * This is cheap enough to be called periodically: unchanged data is
+ * only hashed, against the hash of what was saved.
  */
-void assets_vk_destroy_pipeline_cache(SulfurDevice *dev,
-                                      VkPipelineCache pipeline_cache,
-                                      const char *file_path) {
+void assets_vk_save_pipeline_cache(SulfurDevice *dev, Arena *arena,
+                                   VkPipelineCache pipeline_cache,
+                                   const char *name) {
   if (pipeline_cache == VK_NULL_HANDLE) {
     return;
   }
 
   size_t data_size = 0;
   vkGetPipelineCacheData(dev->device, pipeline_cache, &data_size, NULL);
+  if (data_size == 0) {
+    return;
+  }
 
-  char *data = (char *)malloc(data_size * sizeof(char));
-  vkGetPipelineCacheData(dev->device, pipeline_cache, &data_size, data);
+  char *data = (char *)arena_alloc(arena, data_size * sizeof(char));
+  if (data == NULL) {
+    return;
+  }
 
-  assets_write_file(data, data_size, file_path);
+  VkResult result =
+      vkGetPipelineCacheData(dev->device, pipeline_cache, &data_size, data);
 
-  vkDestroyPipelineCache(dev->device, pipeline_cache, NULL);
+  // Entries can be replaced without the size changing.
+  const uint64_t hash = hash_bytes(data, data_size);
+  if (result == VK_SUCCESS && data_size == pipeline_cache_saved_size &&
+      hash == pipeline_cache_saved_hash) {
+    arena_free(arena, data);
+    return;
+  }
+
+  VkPhysicalDeviceProperties props = {0};
+  vkGetPhysicalDeviceProperties(dev->physical_device, &props);
+
+  if (result == VK_SUCCESS &&
+      validate_pipeline_cache(&props, data, data_size)) {
+    char file_path[128] = {0};
+    get_pipeline_cache_path(&props, name, file_path, sizeof(file_path));
+
+    if (assets_write_cache(data, data_size, file_path) == 0) {
+      pipeline_cache_saved_size = data_size;
+      pipeline_cache_saved_hash = hash;
+    }
+  }
 }
 
 /**
- * Read image data from `file_path`.
+ * Write pipeline cache data to `name` and destroy the cache.
  */
-VkResult assets_vk_create_texture(SulfurDevice *dev, const char *file_path,
-                                  VkFormat format, SulfurTexture *texture) {
-  size_t data_size;
-  char *data = NULL;
-  data = assets_read_file(file_path, &data_size);
-  if (data == NULL) {
-    return -1;
+void assets_vk_destroy_pipeline_cache(SulfurDevice *dev, Arena *arena,
+                                      VkPipelineCache pipeline_cache,
+                                      const char *name) {
+  if (pipeline_cache == VK_NULL_HANDLE) {
+    return;
   }
 
-  int width = 0, height = 0;
-  stbi_uc *pixels = stbi_load_from_memory(
-      (const stbi_uc *)data, data_size, &width, &height, NULL, STBI_rgb_alpha);
+  assets_vk_save_pipeline_cache(dev, arena, pipeline_cache, name);
 
-  free(data);
+  vkDestroyPipelineCache(dev->device, pipeline_cache, NULL);
+}
 
+/**
+ * Read image data from `file_path`.
+ */
+VkResult assets_vk_create_texture(SulfurDevice *dev, Arena *arena,
+                                  const char *file_path, VkFormat format,
+                                  SulfurTexture *texture) {
+  int width = 0, height = 0;
+  unsigned char *pixels = assets_load_image(arena, file_path, &width, &height);
   if (pixels == NULL) {
     return -1;
   }
 
-  VkResult result = sulfur_texture_create_from_image(dev, format, width, height,
-                                                     pixels, texture);
-  stbi_image_free(pixels);
-  return result;
+  return sulfur_texture_create_from_image(dev, format, width, height, pixels,
+                                          texture);
 }
@@ -7,17 +7,33 @@
 #include <sulfur/shader.h>
 #include <sulfur/texture.h>
 
-VkResult assets_vk_create_shader(SulfurDevice *dev, const char *file_path,
+VkResult assets_vk_create_shader(SulfurDevice *dev, Arena *arena,
+                                 const char *file_path,
                                  VkShaderStageFlags shader_stage,
                                  SulfurShader *shader);
 
-VkResult assets_vk_create_texture(SulfurDevice *device, const char *file_path,
-                                  VkFormat format, SulfurTexture *texture);
+VkResult assets_vk_create_texture(SulfurDevice *device, Arena *arena,
+                                  const char *file_path, VkFormat format,
+                                  SulfurTexture *texture);
 
-VkResult assets_vk_create_pipeline_cache(SulfurDevice *dev,
-                                         const char *file_path,
+/**
+ * Create a pipeline cache from the per-device cache file `name`.
+ */
+VkResult assets_vk_create_pipeline_cache(SulfurDevice *dev, Arena *arena,
+                                         const char *name,
                                          VkPipelineCache *pipeline_cache);
 
-void assets_vk_destroy_pipeline_cache(SulfurDevice *dev,
+/**
+ * Atomically write the pipeline cache to its per-device cache file.
+ * The cache data is copied into `arena` first.
+ */
+void assets_vk_save_pipeline_cache(SulfurDevice *dev, Arena *arena,
+                                   VkPipelineCache pipeline_cache,
+                                   const char *name);
+
+/**
+ * Save then destroy the pipeline cache.
+ */
+void assets_vk_destroy_pipeline_cache(SulfurDevice *dev, Arena *arena,
                                       VkPipelineCache pipeline_cache,
-                                      const char *file_path);
+                                      const char *name);
@@ -0,0 +1,263 @@
+#include "autoplay.h"
+
+#include <math.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include "xoroshiro.h"
+
+#include "pacing.h"
+#include "world.h"
+
+// One decision every few physics steps: flapping is on cooldown for 12.
+static const int kAutoplayDecisionSteps = 4;
+
+#define kAutoplayMaxThreads 64
+
+// Heuristic noise added per thread index, to spread the searches apart.
+static const float kAutoplayNoise = 0.02F;
+
+// Weight of vertical speed in the heuristic.
+static const float kAutoplaySpeedWeight = 0.1F;
+
+// Worlds only differ by the bird: keep one per cell of a grid over its
+// height, vertical speed and flap cooldown, so the beam doesn't fill with
+// near copies. Cooldown cell 0 is ready to flap.
+#define kAutoplayCellsY 256
+#define kAutoplayCellsSpeed 64
+#define kAutoplayCellsCooldown 4
+#define kAutoplayCells                                                        \
+  (kAutoplayCellsY * kAutoplayCellsSpeed * kAutoplayCellsCooldown)
+static const float kAutoplayMinSpeed = -2.F;
+static const float kAutoplayMaxSpeed = 4.F;
+
+typedef struct Node {
+  World world;
+  float score;
+} Node;
+
+typedef struct Search {
+  const AutoplayConfig *config;
+  int index;
+  float survived;
+  uint64_t nodes;
+#ifdef _WIN32
+  HANDLE thread;
+#else
+  pthread_t thread;
+#endif
+} Search;
+
+// Set once any search reaches the horizon.
+static atomic_int done = 0;
+
+/**
+ * Rank a world by how close the bird is to the middle of the next gap.
+ */
+static float score(const World *world, const float noise) {
+  const Pipe *next = world_get_next_pipe(world);
+  const float y = world->bird_y + kBirdHeight / 2.F;
+  const float target =
+      next != NULL ? kScreenTop + next->height +
+                         (kPipeHeadHeight * kPipeWidth + next->gap) / 2.F
+                   : 0.F;
+
+  return -fabsf(target - y) - kAutoplaySpeedWeight * fabsf(world->speed_y) +
+         noise;
+}
+
+/**
+ * Grid cell of a playing world.
+ */
+static int get_cell(const World *world) {
+  int y = (int)((world->bird_y - kScreenTop) / kScreenHeight * kAutoplayCellsY);
+  int speed = (int)((world->speed_y - kAutoplayMinSpeed) /
+                    (kAutoplayMaxSpeed - kAutoplayMinSpeed) *
+                    kAutoplayCellsSpeed);
+  y = y < 0 ? 0 : y >= kAutoplayCellsY ? kAutoplayCellsY - 1 : y;
+  speed = speed < 0                      ? 0
+          : speed >= kAutoplayCellsSpeed ? kAutoplayCellsSpeed - 1
+                                         : speed;
+
+  const float cooldown = kThrustDelay - (world->time - world->last_thrust);
+  int wait = 0;
+  if (cooldown > 0.F) {
+    wait = 1 + (int)(cooldown / kThrustDelay * (kAutoplayCellsCooldown - 1));
+    wait = wait >= kAutoplayCellsCooldown ? kAutoplayCellsCooldown - 1 : wait;
+  }
+
+  return (y * kAutoplayCellsSpeed + speed) * kAutoplayCellsCooldown + wait;
+}
+
+static int compare_nodes(const void *a, const void *b) {
+  const float score_a = ((const Node *)a)->score;
+  const float score_b = ((const Node *)b)->score;
+  return (score_a < score_b) - (score_a > score_b);
+}
+
+static void search(Search *search) {
+  const AutoplayConfig *config = search->config;
+  const int width = config->beam_width;
+
+  Node *beam = malloc(sizeof(Node) * width);
+  Node *children = malloc(sizeof(Node) * 2 * width);
+  unsigned char *taken = malloc(kAutoplayCells);
+  if (beam == NULL || children == NULL || taken == NULL) {
+    free(beam);
+    free(children);
+    free(taken);
+    return;
+  }
+
+  uint64_t random_state[2] = {0x9e3779b97f4a7c15 * (search->index + 1),
+                              config->seed + 1};
+  const float noise = kAutoplayNoise * search->index;
+
+  world_seed(&beam[0].world, config->seed);
+  int count = 1;
+
+  while (count > 0 && !atomic_load_explicit(&done, memory_order_relaxed)) {
+    int child_count = 0;
+
+    for (int i = 0; i < count; i++) {
+      for (int flap = 0; flap < 2; flap++) {
+        Node *child = &children[child_count];
+        child->world = beam[i].world;
+
+        // Flapping on cooldown is the same as not flapping.
+        if (flap && !world_thrust(&child->world)) {
+          continue;
+        }
+
+        for (int j = 0; j < kAutoplayDecisionSteps; j++) {
+          world_step(&child->world, kWorldTimeStep);
+        }
+        search->nodes++;
+
+        if (child->world.state != WORLD_PLAYING) {
+          if (child->world.play_time > search->survived) {
+            search->survived = child->world.play_time;
+          }
+          continue;
+        }
+
+        const float r = (float)xoroshiro128plus(random_state) / UINT64_MAX;
+        child->score = score(&child->world, noise * r);
+        child_count++;
+      }
+    }
+
+    qsort(children, child_count, sizeof(Node), compare_nodes);
+
+    // Keep the best world of each cell.
+    memset(taken, 0, kAutoplayCells);
+    count = 0;
+    for (int i = 0; i < child_count && count < width; i++) {
+      const int cell = get_cell(&children[i].world);
+      if (!taken[cell]) {
+        taken[cell] = 1;
+        beam[count++] = children[i];
+      }
+    }
+
+    if (count > 0 && beam[0].world.play_time > search->survived) {
+      search->survived = beam[0].world.play_time;
+    }
+    if (search->survived >= config->horizon) {
+      atomic_store(&done, 1);
+    }
+  }
+
+  free(beam);
+  free(children);
+  free(taken);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI thread_main(LPVOID arg) {
+  search(arg);
+  return 0;
+}
+#else
+static void *thread_main(void *arg) {
+  search(arg);
+  return NULL;
+}
+#endif
+
+static int count_processors(void) {
+#ifdef _WIN32
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return (int)info.dwNumberOfProcessors;
+#else
+  const long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return count > 0 ? (int)count : 1;
+#endif
+}
+
+void autoplay_run(const AutoplayConfig *config, AutoplayResult *result) {
+  int threads = config->threads > 0 ? config->threads : count_processors();
+  if (threads > kAutoplayMaxThreads) {
+    threads = kAutoplayMaxThreads;
+  }
+
+  Search searches[kAutoplayMaxThreads] = {0};
+
+  atomic_store(&done, 0);
+  const double start = pacing_get_time();
+
+  // The first search runs on the calling thread.
+  int started = 1;
+  for (int i = 0; i < threads; i++) {
+    searches[i].config = config;
+    searches[i].index = i;
+    if (i == 0) {
+      continue;
+    }
+#ifdef _WIN32
+    searches[i].thread =
+        CreateThread(NULL, 0, thread_main, &searches[i], 0, NULL);
+    if (searches[i].thread == NULL) {
+      break;
+    }
+#else
+    if (pthread_create(&searches[i].thread, NULL, thread_main,
+                       &searches[i]) != 0) {
+      break;
+    }
+#endif
+    started++;
+  }
+
+  search(&searches[0]);
+
+  for (int i = 1; i < started; i++) {
+#ifdef _WIN32
+    WaitForSingleObject(searches[i].thread, INFINITE);
+    CloseHandle(searches[i].thread);
+#else
+    pthread_join(searches[i].thread, NULL);
+#endif
+  }
+
+  result->seconds = pacing_get_time() - start;
+  result->threads = started;
+  result->survived = 0.F;
+  result->nodes = 0;
+  for (int i = 0; i < started; i++) {
+    if (searches[i].survived > result->survived) {
+      result->survived = searches[i].survived;
+    }
+    result->nodes += searches[i].nodes;
+  }
+  result->winnable = result->survived >= config->horizon;
+}
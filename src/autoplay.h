@@ -0,0 +1,30 @@
+#ifndef FLAP_AUTOPLAY_H
+#define FLAP_AUTOPLAY_H
+
+#include <stdint.h>
+
+typedef struct AutoplayConfig {
+  uint64_t seed;  // For `world_seed`, like the time of day `game_init` uses
+  int threads;    // 0 for one per processor
+  int beam_width; // Worlds kept per decision and per thread
+  float horizon;  // Seconds of play after which a seed counts as winnable
+} AutoplayConfig;
+
+typedef struct AutoplayResult {
+  float survived;  // Longest play time any search reached
+  int winnable;    // Whether it reached the horizon
+  uint64_t nodes;  // Worlds expanded, over all threads
+  double seconds;  // Wall time of the search
+  int threads;     // Threads actually used
+} AutoplayResult;
+
+/**
+ * Search flap/no-flap decisions for the longest surviving run of a seed.
+ * Every thread runs its own beam search, ranking worlds with a heuristic
+ * perturbed differently per thread, until one of them reaches the horizon
+ * or all of them die out. The beams prune, so dying out does not prove
+ * that no run survives.
+ */
+void autoplay_run(const AutoplayConfig *config, AutoplayResult *result);
+
+#endif // FLAP_AUTOPLAY_H
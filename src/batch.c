@@ -0,0 +1,128 @@
+#include "batch.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "options.h"
+#include "scene.h"
+#include "window.h"
+#include "world.h"
+
+// Simulation steps per frame: 60 frames per simulated second, however
+// fast they are drawn.
+static const int kBatchFrameSteps = 2;
+
+static World *worlds = NULL;
+static Sprite *sprites = NULL;
+static int count = 0;
+static int columns = 1;
+static int rows = 1;
+static int frame = 0;
+
+void batch_init() {
+  count = options_get()->batch;
+  if (count <= 0) {
+    count = 0;
+    return;
+  }
+
+  worlds = malloc(sizeof(World) * count);
+  sprites = malloc(sizeof(Sprite) * kNumSprites * count);
+  if (worlds == NULL || sprites == NULL) {
+    window_fail_with_error("Out of memory for the batch!");
+  }
+
+  for (int i = 0; i < count; i++) {
+    world_seed(&worlds[i], (uint64_t)i);
+    scene_build(&worlds[i], &sprites[i * kNumSprites]);
+  }
+
+  // The fewest tiles across that fit every game. Tiles are scaled by the
+  // same factor both ways in `batch_get_tile`, so fewer rows than
+  // columns leaves margins rather than squashing them.
+  columns = (int)ceil(sqrt((double)count));
+  rows = (count + columns - 1) / columns;
+}
+
+int batch_is_running() { return count > 0; }
+
+int batch_get_count() { return count; }
+
+void batch_get_tile(int index, int width, int height, BatchTile *tile) {
+  // There are never more rows than columns.
+  tile->width = width / columns;
+  tile->height = height / columns;
+
+  const int left = (width - columns * tile->width) / 2;
+  const int top = (height - rows * tile->height) / 2;
+  tile->x = left + (index % columns) * tile->width;
+  tile->y = top + (index / columns) * tile->height;
+}
+
+/**
+ * Flap when falling below the middle of the next gap.
+ */
+static void fly(World *world) {
+  const Pipe *pipe = world_get_next_pipe(world);
+  if (pipe == NULL) {
+    return;
+  }
+
+  const float head_height = kPipeHeadHeight * kPipeWidth;
+  const float gap_middle =
+      kScreenTop + pipe->height + (head_height + pipe->gap) / 2.F;
+  const float bird_middle = world->bird_y + kBirdHeight / 2.F;
+  if (world->speed_y > 0.F && bird_middle > gap_middle) {
+    world_thrust(world);
+  }
+}
+
+void batch_update() {
+  if (count == 0) {
+    return;
+  }
+
+  frame++;
+
+  for (int step = 0; step < kBatchFrameSteps; step++) {
+    for (int i = 0; i < count; i++) {
+      // Thrusting after game over would start a new game.
+      if (worlds[i].state == WORLD_PLAYING) {
+        fly(&worlds[i]);
+      }
+      world_step(&worlds[i], kWorldTimeStep);
+    }
+  }
+
+  for (int i = 0; i < count; i++) {
+    scene_build(&worlds[i], &sprites[i * kNumSprites]);
+  }
+}
+
+const Sprite *batch_get_sprites() { return sprites; }
+
+int batch_is_done() {
+  if (count == 0) {
+    return 0;
+  }
+
+  const int frames = options_get()->frames;
+  if (frames > 0 && frame >= frames) {
+    return 1;
+  }
+
+  for (int i = 0; i < count; i++) {
+    if (worlds[i].state != WORLD_GAMEOVER) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+void batch_quit() {
+  free(worlds);
+  free(sprites);
+  worlds = NULL;
+  sprites = NULL;
+  count = 0;
+}
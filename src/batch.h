@@ -0,0 +1,56 @@
+#ifndef FLAP_BATCH_H
+#define FLAP_BATCH_H
+
+#include "sprite.h"
+
+/**
+ * Batch render.
+ * Plays `--batch=COUNT` games, seeded with their index and flown by a
+ * simple pilot, and draws all of them in every frame, one tile of the
+ * frame per game, until every bird crashed. Together with `--capture`
+ * this makes thumbnails or clips of many games in one pass.
+ */
+void batch_init(void);
+
+int batch_is_running(void);
+
+/**
+ * Number of games, each drawn with `kNumSprites` sprites.
+ */
+int batch_get_count(void);
+
+/**
+ * Rectangle of a frame a game is drawn in, in pixels from the top left.
+ */
+typedef struct BatchTile {
+  int x;
+  int y;
+  int width;
+  int height;
+} BatchTile;
+
+/**
+ * Tile of game `index` in a `width` x `height` frame.
+ * Tiles have the shape of the frame and go left to right then top to
+ * bottom, the whole grid centered.
+ */
+void batch_get_tile(int index, int width, int height, BatchTile *tile);
+
+/**
+ * Advance every game by one frame and lay out their sprites.
+ */
+void batch_update(void);
+
+/**
+ * Sprites of every game, one game after the other.
+ */
+const Sprite *batch_get_sprites(void);
+
+/**
+ * Whether every game is over, or the frame count ran out.
+ */
+int batch_is_done(void);
+
+void batch_quit(void);
+
+#endif // FLAP_BATCH_H
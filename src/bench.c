@@ -0,0 +1,250 @@
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "input.h"
+#include "options.h"
+#include "pacing.h"
+#include "scene.h"
+#include "snapshot.h"
+#include "window.h"
+#include "world.h"
+
+// Virtual seconds per frame.
+static const float kBenchFrameTime = 1.F / 60.F;
+
+// Frames rendered before measuring, to fill caches and pipelines.
+static const int kBenchWarmupFrames = 60;
+
+// Measured frames unless --frames says otherwise.
+static const int kBenchDefaultFrames = 1000;
+
+// Thrust this often to cancel gravity on average.
+static const float kBenchThrustPeriod = -kThrust / kGravity;
+
+// The stress scene draws every sprite this many times.
+static const int kBenchStressRepeat = 64;
+
+// Renderer probes time this many frames, after a few warm-up frames.
+static const int kBenchProbeFrames = 32;
+static const int kBenchProbeWarmupFrames = 4;
+
+/**
+ * A scripted scene.
+ */
+typedef struct BenchScene {
+  const char *name;
+  float thrust_period; // 0 means no input
+  int repeat;          // Draws of the scene per frame
+} BenchScene;
+
+static const BenchScene kBenchScenes[] = {
+    // Nothing but falling, then the frozen game over screen.
+    {"idle", 0.F, 1},
+    // Flying through the pipes, restarting after each crash.
+    {"steady", kBenchThrustPeriod, 1},
+    // Steady gameplay with many overlapping translucent sprites.
+    {"stress", kBenchThrustPeriod, kBenchStressRepeat},
+};
+
+static const BenchScene *scene = NULL;
+static const char *renderer_name = NULL;
+
+// Set while a renderer probe draws the stress scene.
+static int probing = 0;
+
+static int measured_frames = 0;
+static int frame = 0;
+static float next_thrust = 0.F;
+
+static double frame_start = 0.;
+static double run_start = 0.;
+static double run_end = 0.;
+
+// Per frame samples, in seconds.
+static double *cpu_times = NULL;
+static double *gpu_times = NULL;
+static int cpu_count = 0;
+static int gpu_count = 0;
+
+void bench_init(const char *renderer) {
+  const char *name = options_get()->bench;
+  if (name == NULL) {
+    return;
+  }
+
+  for (size_t i = 0; i < sizeof(kBenchScenes) / sizeof(kBenchScenes[0]);
+       i++) {
+    if (strcmp(kBenchScenes[i].name, name) == 0) {
+      scene = &kBenchScenes[i];
+    }
+  }
+  if (scene == NULL) {
+    window_fail_with_error("Unknown benchmark scene!");
+  }
+
+  renderer_name = renderer;
+
+  measured_frames = options_get()->frames > 0 ? options_get()->frames
+                                              : kBenchDefaultFrames;
+
+  cpu_times = malloc(sizeof(double) * measured_frames);
+  gpu_times = malloc(sizeof(double) * measured_frames);
+  if (cpu_times == NULL || gpu_times == NULL) {
+    window_fail_with_error("Out of memory for benchmark samples!");
+  }
+
+  next_thrust = scene->thrust_period;
+}
+
+int bench_is_running() { return scene != NULL; }
+
+float bench_get_time() { return (float)frame * kBenchFrameTime; }
+
+int bench_get_repeat() {
+  if (probing) {
+    return kBenchStressRepeat;
+  }
+  return scene != NULL ? scene->repeat : 1;
+}
+
+double bench_probe(void (*draw)(void), void (*present)(void),
+                   void (*finish)(void)) {
+  probing = 1;
+
+  World world;
+  world_seed(&world, 0);
+  float next_thrust = kBenchThrustPeriod;
+
+  double start = 0.;
+  for (int i = 0; i < kBenchProbeWarmupFrames + kBenchProbeFrames; i++) {
+    if (i == kBenchProbeWarmupFrames) {
+      start = pacing_get_time();
+    }
+
+    // Steady gameplay, stepped on the virtual clock.
+    const float now = (float)(i + 1) * kBenchFrameTime;
+    while (next_thrust <= now) {
+      world_thrust(&world);
+      next_thrust += kBenchThrustPeriod;
+    }
+    world_step(&world, kBenchFrameTime);
+
+    Snapshot *snapshot = snapshot_begin();
+    scene_build(&world, snapshot->sprites);
+    snapshot->ghost_count = 0;
+    snapshot->idle = 0;
+    snapshot_publish();
+    snapshot_acquire();
+
+    draw();
+    present();
+  }
+  finish();
+  const double frame_time = (pacing_get_time() - start) / kBenchProbeFrames;
+
+  probing = 0;
+  return frame_time;
+}
+
+void bench_begin_frame() {
+  if (scene == NULL) {
+    return;
+  }
+
+  frame++;
+
+  if (scene->thrust_period > 0.F) {
+    const float now = bench_get_time();
+    while (next_thrust <= now) {
+      input_push(INPUT_THRUST, next_thrust);
+      next_thrust += scene->thrust_period;
+    }
+  }
+
+  frame_start = pacing_get_time();
+  if (frame == kBenchWarmupFrames + 1) {
+    run_start = frame_start;
+  }
+}
+
+void bench_frame_submitted() {
+  if (scene == NULL || frame <= kBenchWarmupFrames) {
+    return;
+  }
+
+  const double now = pacing_get_time();
+  if (cpu_count < measured_frames) {
+    cpu_times[cpu_count++] = now - frame_start;
+  }
+  run_end = now;
+}
+
+void bench_frame_gpu_time(double seconds) {
+  if (scene == NULL || frame <= kBenchWarmupFrames) {
+    return;
+  }
+
+  if (gpu_count < measured_frames) {
+    gpu_times[gpu_count++] = seconds;
+  }
+}
+
+int bench_is_done() {
+  return scene != NULL && frame >= kBenchWarmupFrames + measured_frames;
+}
+
+static int compare_times(const void *a, const void *b) {
+  const double x = *(const double *)a;
+  const double y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * Print mean, median, 99th percentile and maximum in milliseconds.
+ */
+static void print_stats(const char *name, double *times, int count) {
+  if (count == 0) {
+    printf("  \"%s\": null", name);
+    return;
+  }
+
+  qsort(times, count, sizeof(double), compare_times);
+
+  double sum = 0.;
+  for (int i = 0; i < count; i++) {
+    sum += times[i];
+  }
+
+  printf("  \"%s\": {\"mean\": %.4f, \"median\": %.4f, \"p99\": %.4f, "
+         "\"max\": %.4f}",
+         name, sum / count * 1000., times[count / 2] * 1000.,
+         times[(count * 99) / 100] * 1000., times[count - 1] * 1000.);
+}
+
+void bench_report() {
+  if (scene == NULL) {
+    return;
+  }
+
+  // Wall clock time also covers presenting.
+  const double seconds = run_end - run_start;
+
+  printf("{\n");
+  printf("  \"scene\": \"%s\",\n", scene->name);
+  printf("  \"renderer\": \"%s\",\n", renderer_name);
+  printf("  \"frames\": %d,\n", cpu_count);
+  printf("  \"seconds\": %.4f,\n", seconds);
+  printf("  \"fps\": %.2f,\n", seconds > 0. ? cpu_count / seconds : 0.);
+  print_stats("cpu_ms", cpu_times, cpu_count);
+  printf(",\n");
+  print_stats("gpu_ms", gpu_times, gpu_count);
+  printf("\n}\n");
+
+  free(cpu_times);
+  free(gpu_times);
+  cpu_times = NULL;
+  gpu_times = NULL;
+}
@@ -0,0 +1,61 @@
+#ifndef FLAP_BENCH_H
+#define FLAP_BENCH_H
+
+/**
+ * Render benchmark.
+ * Runs the real render loop on a virtual clock with scripted input for a
+ * fixed number of frames, then prints frame times as JSON to stdout.
+ * Enabled by `--bench=SCENE`, see `bench.c` for the scenes.
+ */
+void bench_init(const char *renderer);
+
+int bench_is_running(void);
+
+/**
+ * The virtual clock, in seconds.
+ * Stands in for `window_get_time` while benchmarking.
+ */
+float bench_get_time(void);
+
+/**
+ * How many times to draw the scene each frame.
+ * Every backend makes one draw call, or software pass, per repeat.
+ */
+int bench_get_repeat(void);
+
+/**
+ * Time a renderer probe, see `renderer.h`: a few frames of the stress
+ * scene, each published as a snapshot, then drawn with `draw` and shown
+ * with `present`. `finish` waits for the GPU before the clock stops.
+ * Return seconds per frame.
+ */
+double bench_probe(void (*draw)(void), void (*present)(void),
+                   void (*finish)(void));
+
+/**
+ * Advance the virtual clock by one frame and push scripted input.
+ * Starts the CPU frame timer.
+ */
+void bench_begin_frame(void);
+
+/**
+ * The frame was submitted: stop the CPU frame timer.
+ */
+void bench_frame_submitted(void);
+
+/**
+ * Record the GPU time of a frame, usually a few frames late.
+ */
+void bench_frame_gpu_time(double seconds);
+
+/**
+ * Whether all frames were rendered.
+ */
+int bench_is_done(void);
+
+/**
+ * Print the results to stdout.
+ */
+void bench_report(void);
+
+#endif // FLAP_BENCH_H
@@ -0,0 +1,311 @@
+#include "capture.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#elif !defined(__EMSCRIPTEN__)
+#include <pthread.h>
+#endif
+
+#include "options.h"
+#include "pacing.h"
+#include "window.h"
+
+// Frame rate written to Y4M headers when the frame rate is not capped.
+static const int kCaptureDefaultFps = 60;
+
+// Frames waiting for the writer thread. Must be a power of two.
+#define kCaptureQueueSize 4
+
+// How long the writer thread sleeps when it has caught up.
+static const double kCaptureIdlePeriod = 1. / 500.;
+
+static FILE *file = NULL;
+static int capture_width = 0;
+static int capture_height = 0;
+
+// Y4M frames are converted here: the Y plane, then U and V.
+static uint8_t *planes = NULL;
+
+/**
+ * Frames handed over by the render thread, top row first and tightly
+ * packed, in a single producer, single consumer ring like the input
+ * queue. Converting and writing them happens on the writer thread.
+ */
+static uint8_t *queue[kCaptureQueueSize] = {NULL};
+static atomic_uint head = 0; // Next frame to write, owned by the writer
+static atomic_uint tail = 0; // Next slot to fill, owned by the renderer
+
+static atomic_int running = 0;
+static int threaded = 0;
+
+#ifdef _WIN32
+static HANDLE thread = NULL;
+#elif !defined(__EMSCRIPTEN__)
+static pthread_t thread;
+#endif
+
+static unsigned int frames_written = 0; // Owned by the writer
+static unsigned int frames_dropped = 0;
+
+static int ends_with(const char *text, const char *suffix) {
+  const size_t text_length = strlen(text);
+  const size_t suffix_length = strlen(suffix);
+  return text_length >= suffix_length &&
+         strcmp(text + text_length - suffix_length, suffix) == 0;
+}
+
+static uint8_t clamp_byte(int value) {
+  return value < 0 ? 0 : value > 255 ? 255 : (uint8_t)value;
+}
+
+/**
+ * Convert to full range BT.601 YCbCr, with chroma averaged over 2x2
+ * pixels, as Y4M "C420jpeg" expects.
+ */
+static void convert_to_yuv420(const uint8_t *top_row, ptrdiff_t stride) {
+  const int chroma_width = (capture_width + 1) / 2;
+  const int chroma_height = (capture_height + 1) / 2;
+  uint8_t *y_plane = planes;
+  uint8_t *u_plane = y_plane + (size_t)capture_width * capture_height;
+  uint8_t *v_plane = u_plane + (size_t)chroma_width * chroma_height;
+
+  for (int y = 0; y < capture_height; y++) {
+    const uint8_t *row = top_row + y * stride;
+    for (int x = 0; x < capture_width; x++) {
+      const int r = row[x * 4];
+      const int g = row[x * 4 + 1];
+      const int b = row[x * 4 + 2];
+      y_plane[(size_t)y * capture_width + x] =
+          (uint8_t)((77 * r + 150 * g + 29 * b + 128) >> 8);
+    }
+  }
+
+  for (int cy = 0; cy < chroma_height; cy++) {
+    for (int cx = 0; cx < chroma_width; cx++) {
+      int r = 0, g = 0, b = 0, count = 0;
+      for (int y = cy * 2; y < cy * 2 + 2 && y < capture_height; y++) {
+        const uint8_t *row = top_row + y * stride;
+        for (int x = cx * 2; x < cx * 2 + 2 && x < capture_width; x++) {
+          r += row[x * 4];
+          g += row[x * 4 + 1];
+          b += row[x * 4 + 2];
+          count++;
+        }
+      }
+      r /= count;
+      g /= count;
+      b /= count;
+
+      const size_t i = (size_t)cy * chroma_width + cx;
+      u_plane[i] = clamp_byte((-43 * r - 85 * g + 128 * b + 32896) >> 8);
+      v_plane[i] = clamp_byte((128 * r - 107 * g - 21 * b + 32896) >> 8);
+    }
+  }
+}
+
+/**
+ * Write a packed frame in the format of the file.
+ */
+static void write_frame(const uint8_t *pixels) {
+  if (planes != NULL) {
+    convert_to_yuv420(pixels, (ptrdiff_t)capture_width * 4);
+    const size_t chroma_size = (size_t)((capture_width + 1) / 2) *
+                               (size_t)((capture_height + 1) / 2);
+    fputs("FRAME\n", file);
+    fwrite(planes, (size_t)capture_width * capture_height + 2 * chroma_size, 1,
+           file);
+  } else {
+    fwrite(pixels, (size_t)capture_width * capture_height * 4, 1, file);
+  }
+
+  frames_written++;
+}
+
+/**
+ * Write every queued frame, and return whether there were any.
+ */
+static int drain_queue(void) {
+  const unsigned int h = atomic_load_explicit(&head, memory_order_relaxed);
+  const unsigned int t = atomic_load_explicit(&tail, memory_order_acquire);
+
+  for (unsigned int i = h; i != t; i++) {
+    write_frame(queue[i & (kCaptureQueueSize - 1)]);
+    atomic_store_explicit(&head, i + 1, memory_order_release);
+  }
+  return h != t;
+}
+
+/**
+ * Write frames as they come until stopped, then whatever is left.
+ */
+static void run(void) {
+  while (atomic_load_explicit(&running, memory_order_relaxed)) {
+    if (!drain_queue()) {
+      pacing_sleep_until(pacing_get_time() + kCaptureIdlePeriod);
+    }
+  }
+  drain_queue();
+}
+
+#ifdef _WIN32
+static DWORD WINAPI thread_main(LPVOID arg) {
+  (void)arg;
+  run();
+  return 0;
+}
+#elif !defined(__EMSCRIPTEN__)
+static void *thread_main(void *arg) {
+  (void)arg;
+  run();
+  return NULL;
+}
+#endif
+
+/**
+ * Start the writer thread. Without one, frames are written as they come.
+ */
+static void start_writer(void) {
+  atomic_store(&running, 1);
+
+#ifdef _WIN32
+  thread = CreateThread(NULL, 0, thread_main, NULL, 0, NULL);
+  threaded = thread != NULL;
+#elif !defined(__EMSCRIPTEN__)
+  threaded = pthread_create(&thread, NULL, thread_main, NULL) == 0;
+#endif
+
+  if (!threaded) {
+    atomic_store(&running, 0);
+  }
+}
+
+static void stop_writer(void) {
+  if (!threaded) {
+    return;
+  }
+
+  atomic_store(&running, 0);
+
+#ifdef _WIN32
+  WaitForSingleObject(thread, INFINITE);
+  CloseHandle(thread);
+#elif !defined(__EMSCRIPTEN__)
+  pthread_join(thread, NULL);
+#endif
+  threaded = 0;
+}
+
+void capture_init(int width, int height) {
+  const char *path = options_get()->capture;
+  if (path == NULL || file != NULL) {
+    return;
+  }
+
+#ifdef _WIN32
+  fopen_s(&file, path, "wb");
+#else
+  file = fopen(path, "wbe");
+#endif
+  if (file == NULL) {
+    window_fail_with_error("Could not open the capture file!");
+    return;
+  }
+
+  capture_width = width;
+  capture_height = height;
+
+  if (ends_with(path, ".y4m")) {
+    const size_t chroma_size =
+        (size_t)((width + 1) / 2) * (size_t)((height + 1) / 2);
+    planes = malloc((size_t)width * height + 2 * chroma_size);
+    if (planes == NULL) {
+      window_fail_with_error("Out of memory for the capture!");
+    }
+
+    // The conversion uses full range levels, which players otherwise
+    // assume to be limited.
+    const float max_fps = options_get()->max_fps;
+    fprintf(file,
+            "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg XCOLORRANGE=FULL\n",
+            width, height, max_fps > 0.F ? (int)max_fps : kCaptureDefaultFps);
+  }
+
+  for (int i = 0; i < kCaptureQueueSize; i++) {
+    queue[i] = malloc((size_t)width * height * 4);
+    if (queue[i] == NULL) {
+      window_fail_with_error("Out of memory for the capture!");
+    }
+  }
+
+  start_writer();
+}
+
+int capture_is_running(void) { return file != NULL; }
+
+void capture_get_size(int *width, int *height) {
+  *width = capture_width;
+  *height = capture_height;
+}
+
+void capture_write_frame(const uint8_t *top_row, ptrdiff_t stride) {
+  if (file == NULL) {
+    return;
+  }
+
+  // Clips should not skip frames: when the writer falls behind, which
+  // offline batch renders can make it do, wait for it.
+  const unsigned int t = atomic_load_explicit(&tail, memory_order_relaxed);
+  while (t - atomic_load_explicit(&head, memory_order_acquire) ==
+         kCaptureQueueSize) {
+    pacing_sleep_until(pacing_get_time() + kCaptureIdlePeriod);
+  }
+
+  uint8_t *pixels = queue[t & (kCaptureQueueSize - 1)];
+  const size_t row_size = (size_t)capture_width * 4;
+  if (stride == (ptrdiff_t)row_size) {
+    memcpy(pixels, top_row, row_size * capture_height);
+  } else {
+    for (int y = 0; y < capture_height; y++) {
+      memcpy(pixels + y * row_size, top_row + y * stride, row_size);
+    }
+  }
+
+  atomic_store_explicit(&tail, t + 1, memory_order_release);
+
+  if (!threaded) {
+    drain_queue();
+  }
+}
+
+void capture_drop_frame(void) { frames_dropped++; }
+
+void capture_quit(void) {
+  if (file == NULL) {
+    return;
+  }
+
+  stop_writer();
+
+  fclose(file);
+  file = NULL;
+
+  free(planes);
+  planes = NULL;
+
+  for (int i = 0; i < kCaptureQueueSize; i++) {
+    free(queue[i]);
+    queue[i] = NULL;
+  }
+
+  printf("Captured %u frames of %dx%d to %s", frames_written, capture_width,
+         capture_height, options_get()->capture);
+  if (frames_dropped > 0) {
+    printf(", dropped %u", frames_dropped);
+  }
+  printf("\n");
+}
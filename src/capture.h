@@ -0,0 +1,42 @@
+#ifndef FLAP_CAPTURE_H
+#define FLAP_CAPTURE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Video capture of rendered frames, for highlight clips.
+ * Files ending in ".y4m" get a YUV4MPEG2 4:2:0 stream, any other name
+ * raw RGBA8 frames back to back. Backends read frames back
+ * asynchronously and hand them over here a few frames late; a writer
+ * thread converts and writes them out.
+ */
+
+/**
+ * Start capturing `width` x `height` frames if --capture asked for it.
+ */
+void capture_init(int width, int height);
+
+int capture_is_running(void);
+
+void capture_get_size(int *width, int *height);
+
+/**
+ * Queue a copy of a frame of RGBA8 pixels for writing. `stride` is the
+ * distance in bytes from a row to the one below, negative for images
+ * stored bottom-up. Waits only if the writer is several frames behind.
+ */
+void capture_write_frame(const uint8_t *top_row, ptrdiff_t stride);
+
+/**
+ * Count a frame that could not be read back in time.
+ */
+void capture_drop_frame(void);
+
+/**
+ * Finish writing queued frames, close the file and print how many
+ * frames were written.
+ */
+void capture_quit(void);
+
+#endif // FLAP_CAPTURE_H
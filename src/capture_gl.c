@@ -0,0 +1,114 @@
+#include "capture_gl.h"
+
+#include "capture.h"
+#include "window.h"
+
+// Frames between queueing a read back and mapping its pixel buffer.
+#define kCaptureRingSize 3
+
+// Nanoseconds to wait for a fence that should have long signaled.
+static const GLuint64 kFenceTimeout = 1000000000;
+
+typedef struct CaptureSlot {
+  GLuint buffer;
+  GLsync fence; // Set while a read back is in flight
+} CaptureSlot;
+
+static CaptureSlot slots[kCaptureRingSize] = {{0}};
+static unsigned int capture_frame = 0;
+
+void capture_gl_init(void) {
+  GLint viewport[4] = {0};
+  glGetIntegerv(GL_VIEWPORT, viewport);
+
+  capture_init(viewport[2], viewport[3]);
+  if (!capture_is_running()) {
+    return;
+  }
+
+  // OpenGL 3.2 or OpenGL ES 3.0.
+  if (!glad_glFenceSync || !glad_glMapBufferRange) {
+    window_fail_with_error("Capture needs fences and buffer mapping!");
+  }
+
+  const GLsizeiptr size = (GLsizeiptr)viewport[2] * viewport[3] * 4;
+  for (int i = 0; i < kCaptureRingSize; i++) {
+    glGenBuffers(1, &slots[i].buffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slots[i].buffer);
+    glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+/**
+ * Wait for the read back of `slot`, which is normally done already,
+ * and write its pixels out.
+ */
+static void write_slot(CaptureSlot *slot) {
+  const GLenum status =
+      glClientWaitSync(slot->fence, GL_SYNC_FLUSH_COMMANDS_BIT, kFenceTimeout);
+  glDeleteSync(slot->fence);
+  slot->fence = NULL;
+
+  if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+    capture_drop_frame();
+    return;
+  }
+
+  int width = 0;
+  int height = 0;
+  capture_get_size(&width, &height);
+  const ptrdiff_t stride = (ptrdiff_t)width * 4;
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->buffer);
+  const uint8_t *pixels = glMapBufferRange(
+      GL_PIXEL_PACK_BUFFER, 0, stride * height, GL_MAP_READ_BIT);
+  if (pixels != NULL) {
+    // Rows start at the bottom in OpenGL.
+    capture_write_frame(pixels + stride * (height - 1), -stride);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  } else {
+    capture_drop_frame();
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void capture_gl_frame(void) {
+  if (!capture_is_running()) {
+    return;
+  }
+
+  CaptureSlot *slot = &slots[capture_frame % kCaptureRingSize];
+  if (slot->fence != NULL) {
+    write_slot(slot);
+  }
+
+  int width = 0;
+  int height = 0;
+  capture_get_size(&width, &height);
+
+  // With a pack buffer bound this only queues a copy on the GPU.
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->buffer);
+  glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+  capture_frame++;
+}
+
+void capture_gl_quit(void) {
+  if (!capture_is_running()) {
+    return;
+  }
+
+  for (int i = 0; i < kCaptureRingSize; i++) {
+    CaptureSlot *slot = &slots[(capture_frame + i) % kCaptureRingSize];
+    if (slot->fence != NULL) {
+      write_slot(slot);
+    }
+    glDeleteBuffers(1, &slot->buffer);
+    slot->buffer = 0;
+  }
+
+  capture_quit();
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <glad/glad.h>
+
+/**
+ * Start capturing at the current viewport size if asked for.
+ */
+void capture_gl_init(void);
+
+/**
+ * Queue a read back of the frame just drawn into a pixel buffer and
+ * write out the one queued a full ring earlier.
+ */
+void capture_gl_frame(void);
+
+/**
+ * Write out the frames still in flight and stop capturing.
+ */
+void capture_gl_quit(void);
@@ -0,0 +1,454 @@
+#include "capture_vk.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "capture.h"
+#include "sprite_vk.h"
+#include "window.h"
+
+// Swapchain images beyond this are not captured.
+#define kMaxCaptureTargets 8
+
+/**
+ * Where the frames of one swapchain image are drawn again and read back.
+ * Command buffers are recorded once per swapchain image, so each one
+ * owns a target and nothing is shared between frames in flight.
+ */
+typedef struct CaptureTarget {
+  VkImage image;
+  VkDeviceMemory image_memory;
+  VkImageView view;
+  VkFramebuffer framebuffer;
+  VkBuffer buffer;
+  VkDeviceMemory buffer_memory;
+  const uint8_t *pixels; // Persistently mapped staging buffer
+} CaptureTarget;
+
+static CaptureTarget targets[kMaxCaptureTargets];
+static uint32_t target_count = 0;
+static uint32_t image_count = 0;
+
+static VkExtent2D extent = {0, 0};
+static VkRenderPass render_pass = VK_NULL_HANDLE;
+static VkPipeline pipelines[2] = {0}; // Sprites, ghosts
+
+// A timestamp per target, written once its copy is done. Which image was
+// drawn is not known here: timestamps tell which frames are new and in
+// which order they were drawn.
+static VkQueryPool query_pool = VK_NULL_HANDLE;
+static uint64_t last_timestamp = 0;
+static uint32_t polled_frames = 0;
+
+// Cached staging memory reads faster but may need invalidating.
+static int coherent = 1;
+
+// Frames are copied out of staging memory, then checked untouched.
+static uint8_t *frame_copy = NULL;
+
+static int is_srgb(VkFormat format) {
+  return format == VK_FORMAT_B8G8R8A8_SRGB ||
+         format == VK_FORMAT_R8G8B8A8_SRGB ||
+         format == VK_FORMAT_A8B8G8R8_SRGB_PACK32;
+}
+
+/**
+ * Allocate memory with all of `flags`. Return 0 if there is no such type.
+ */
+static int allocate_memory(SulfurDevice *dev,
+                           const VkMemoryRequirements *requirements,
+                           VkMemoryPropertyFlags flags,
+                           VkDeviceMemory *memory) {
+  VkPhysicalDeviceMemoryProperties properties;
+  vkGetPhysicalDeviceMemoryProperties(dev->physical_device, &properties);
+
+  for (uint32_t i = 0; i < properties.memoryTypeCount; i++) {
+    if ((requirements->memoryTypeBits & (1U << i)) &&
+        (properties.memoryTypes[i].propertyFlags & flags) == flags) {
+      VkMemoryAllocateInfo memory_info = {0};
+      memory_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+      memory_info.allocationSize = requirements->size;
+      memory_info.memoryTypeIndex = i;
+      return vkAllocateMemory(dev->device, &memory_info, NULL, memory) ==
+             VK_SUCCESS;
+    }
+  }
+  return 0;
+}
+
+/**
+ * A single color attachment left ready to copy from.
+ */
+static void create_render_pass(SulfurDevice *dev, VkFormat format) {
+  const VkAttachmentDescription attachment = {
+      .format = format,
+      .samples = VK_SAMPLE_COUNT_1_BIT,
+      .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+      .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+      .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+      .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+      .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+      .finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL};
+
+  const VkAttachmentReference reference = {
+      0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+
+  const VkSubpassDescription subpass = {
+      .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+      .colorAttachmentCount = 1,
+      .pColorAttachments = &reference};
+
+  // Drawing waits for the previous copy out of the image and the copy
+  // waits for drawing.
+  const VkSubpassDependency dependencies[2] = {
+      {.srcSubpass = VK_SUBPASS_EXTERNAL,
+       .dstSubpass = 0,
+       .srcStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT,
+       .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+       .srcAccessMask = 0,
+       .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT},
+      {.srcSubpass = 0,
+       .dstSubpass = VK_SUBPASS_EXTERNAL,
+       .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+       .dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT,
+       .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+       .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT}};
+
+  VkRenderPassCreateInfo render_pass_info = {0};
+  render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+  render_pass_info.attachmentCount = 1;
+  render_pass_info.pAttachments = &attachment;
+  render_pass_info.subpassCount = 1;
+  render_pass_info.pSubpasses = &subpass;
+  render_pass_info.dependencyCount = 2;
+  render_pass_info.pDependencies = dependencies;
+
+  if (vkCreateRenderPass(dev->device, &render_pass_info, NULL,
+                         &render_pass) != VK_SUCCESS) {
+    window_fail_with_error("Capture: vkCreateRenderPass");
+  }
+}
+
+static void create_target(SulfurDevice *dev, VkFormat format,
+                          CaptureTarget *target) {
+  VkImageCreateInfo image_info = {0};
+  image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+  image_info.imageType = VK_IMAGE_TYPE_2D;
+  image_info.format = format;
+  image_info.extent.width = extent.width;
+  image_info.extent.height = extent.height;
+  image_info.extent.depth = 1;
+  image_info.mipLevels = 1;
+  image_info.arrayLayers = 1;
+  image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+  image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+  image_info.usage =
+      VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+  image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+  VkMemoryRequirements requirements;
+  if (vkCreateImage(dev->device, &image_info, NULL, &target->image) !=
+      VK_SUCCESS) {
+    window_fail_with_error("Capture: vkCreateImage");
+  }
+  vkGetImageMemoryRequirements(dev->device, target->image, &requirements);
+  if (!allocate_memory(dev, &requirements,
+                       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                       &target->image_memory) ||
+      vkBindImageMemory(dev->device, target->image, target->image_memory,
+                        0) != VK_SUCCESS) {
+    window_fail_with_error("Capture: vkAllocateMemory");
+  }
+
+  VkImageViewCreateInfo view_info = {0};
+  view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+  view_info.image = target->image;
+  view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+  view_info.format = format;
+  view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  view_info.subresourceRange.levelCount = 1;
+  view_info.subresourceRange.layerCount = 1;
+  if (vkCreateImageView(dev->device, &view_info, NULL, &target->view) !=
+      VK_SUCCESS) {
+    window_fail_with_error("Capture: vkCreateImageView");
+  }
+
+  VkFramebufferCreateInfo framebuffer_info = {0};
+  framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+  framebuffer_info.renderPass = render_pass;
+  framebuffer_info.attachmentCount = 1;
+  framebuffer_info.pAttachments = &target->view;
+  framebuffer_info.width = extent.width;
+  framebuffer_info.height = extent.height;
+  framebuffer_info.layers = 1;
+  if (vkCreateFramebuffer(dev->device, &framebuffer_info, NULL,
+                          &target->framebuffer) != VK_SUCCESS) {
+    window_fail_with_error("Capture: vkCreateFramebuffer");
+  }
+
+  VkBufferCreateInfo buffer_info = {0};
+  buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  buffer_info.size = (VkDeviceSize)extent.width * extent.height * 4;
+  buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  if (vkCreateBuffer(dev->device, &buffer_info, NULL, &target->buffer) !=
+      VK_SUCCESS) {
+    window_fail_with_error("Capture: vkCreateBuffer");
+  }
+  vkGetBufferMemoryRequirements(dev->device, target->buffer, &requirements);
+
+  static const VkMemoryPropertyFlags kStagingFlags[3] = {
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT |
+          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT};
+
+  int allocated = 0;
+  for (int i = 0; i < 3 && !allocated; i++) {
+    allocated = allocate_memory(dev, &requirements, kStagingFlags[i],
+                                &target->buffer_memory);
+    coherent = (kStagingFlags[i] & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+  }
+
+  void *pixels = NULL;
+  if (!allocated ||
+      vkBindBufferMemory(dev->device, target->buffer, target->buffer_memory,
+                         0) != VK_SUCCESS ||
+      vkMapMemory(dev->device, target->buffer_memory, 0, VK_WHOLE_SIZE, 0,
+                  &pixels) != VK_SUCCESS) {
+    window_fail_with_error("Capture: vkMapMemory");
+  }
+  target->pixels = pixels;
+}
+
+static void destroy_target(SulfurDevice *dev, CaptureTarget *target) {
+  vkUnmapMemory(dev->device, target->buffer_memory);
+  vkDestroyBuffer(dev->device, target->buffer, NULL);
+  vkFreeMemory(dev->device, target->buffer_memory, NULL);
+  vkDestroyFramebuffer(dev->device, target->framebuffer, NULL);
+  vkDestroyImageView(dev->device, target->view, NULL);
+  vkDestroyImage(dev->device, target->image, NULL);
+  vkFreeMemory(dev->device, target->image_memory, NULL);
+  memset(target, 0, sizeof(*target));
+}
+
+void capture_vk_init(SulfurDevice *dev, const SulfurSwapchain *swapchain) {
+  extent = swapchain->info.imageExtent;
+  capture_init((int)extent.width, (int)extent.height);
+  if (!capture_is_running()) {
+    return;
+  }
+
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(dev->physical_device, &properties);
+  if (!properties.limits.timestampComputeAndGraphics) {
+    window_fail_with_error("Capture needs GPU timestamps!");
+  }
+
+  // Captures are RGBA, encoded like the swapchain.
+  const VkFormat format = is_srgb(swapchain->info.imageFormat)
+                              ? VK_FORMAT_R8G8B8A8_SRGB
+                              : VK_FORMAT_R8G8B8A8_UNORM;
+
+  image_count = swapchain->image_count;
+  target_count =
+      image_count < kMaxCaptureTargets ? image_count : kMaxCaptureTargets;
+
+  create_render_pass(dev, format);
+
+  VkQueryPoolCreateInfo pool_info = {0};
+  pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+  pool_info.queryCount = kMaxCaptureTargets;
+  if (vkCreateQueryPool(dev->device, &pool_info, NULL, &query_pool) !=
+      VK_SUCCESS) {
+    window_fail_with_error("Capture: vkCreateQueryPool");
+  }
+
+  frame_copy = malloc((size_t)extent.width * extent.height * 4);
+  if (frame_copy == NULL) {
+    window_fail_with_error("Out of memory for the capture!");
+  }
+
+  for (uint32_t i = 0; i < target_count; i++) {
+    create_target(dev, format, &targets[i]);
+  }
+}
+
+void capture_vk_create_pipelines(SulfurDevice *dev, uint32_t count,
+                                 const VkGraphicsPipelineCreateInfo *infos,
+                                 VkPipelineCache pipeline_cache) {
+  if (!capture_is_running()) {
+    return;
+  }
+
+  VkGraphicsPipelineCreateInfo capture_infos[2] = {0};
+  for (uint32_t i = 0; i < count; i++) {
+    capture_infos[i] = infos[i];
+    capture_infos[i].renderPass = render_pass;
+    capture_infos[i].subpass = 0;
+  }
+
+  if (vkCreateGraphicsPipelines(dev->device, pipeline_cache, count,
+                                capture_infos, NULL,
+                                pipelines) != VK_SUCCESS) {
+    window_fail_with_error("Capture: vkCreateGraphicsPipelines");
+  }
+}
+
+void capture_vk_record(VkCommandBuffer cmd_buf, uint32_t index,
+                       VkDescriptorSet descriptor_set,
+                       const VkClearValue *clear_color) {
+  if (!capture_is_running() || index >= target_count) {
+    return;
+  }
+
+  const CaptureTarget *target = &targets[index];
+
+  vkCmdResetQueryPool(cmd_buf, query_pool, index, 1);
+
+  VkRenderPassBeginInfo render_pass_info = {0};
+  render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+  render_pass_info.renderPass = render_pass;
+  render_pass_info.framebuffer = target->framebuffer;
+  render_pass_info.renderArea.extent = extent;
+  render_pass_info.clearValueCount = 1;
+  render_pass_info.pClearValues = clear_color;
+  vkCmdBeginRenderPass(cmd_buf, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+
+  vkCmdBindPipeline(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines[0]);
+
+  const VkViewport viewport = {.x = 0.F,
+                               .y = 0.F,
+                               .width = (float)extent.width,
+                               .height = (float)extent.height,
+                               .minDepth = 0.F,
+                               .maxDepth = 1.F};
+  const VkRect2D scissor = {.offset = {0, 0}, .extent = extent};
+  vkCmdSetViewport(cmd_buf, 0, 1, &viewport);
+  vkCmdSetScissor(cmd_buf, 0, 1, &scissor);
+
+  vkCmdBindDescriptorSets(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                          sprite_get_pipeline_layout(), 0, 1, &descriptor_set,
+                          0, NULL);
+
+  sprite_record_command_buffer(cmd_buf, extent, pipelines[1]);
+
+  vkCmdEndRenderPass(cmd_buf);
+
+  VkBufferImageCopy region = {0};
+  region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  region.imageSubresource.layerCount = 1;
+  region.imageExtent.width = extent.width;
+  region.imageExtent.height = extent.height;
+  region.imageExtent.depth = 1;
+  vkCmdCopyImageToBuffer(cmd_buf, target->image,
+                         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, target->buffer,
+                         1, &region);
+
+  VkBufferMemoryBarrier barrier = {0};
+  barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.buffer = target->buffer;
+  barrier.size = VK_WHOLE_SIZE;
+  vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_HOST_BIT, 0, 0, NULL, 1, &barrier, 0,
+                       NULL);
+
+  vkCmdWriteTimestamp(cmd_buf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                      query_pool, index);
+}
+
+/**
+ * Return when the copy of target `index` finished, or 0 if it has not.
+ */
+static uint64_t get_timestamp(SulfurDevice *dev, uint32_t index) {
+  uint64_t result[2] = {0}; // Timestamp and availability
+  if (vkGetQueryPoolResults(dev->device, query_pool, index, 1, sizeof(result),
+                            result, sizeof(result),
+                            VK_QUERY_RESULT_64_BIT |
+                                VK_QUERY_RESULT_WITH_AVAILABILITY_BIT) !=
+          VK_SUCCESS ||
+      result[1] == 0) {
+    return 0;
+  }
+  return result[0];
+}
+
+static void write_target(SulfurDevice *dev, uint32_t index,
+                         uint64_t timestamp) {
+  const CaptureTarget *target = &targets[index];
+
+  if (!coherent) {
+    VkMappedMemoryRange range = {0};
+    range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    range.memory = target->buffer_memory;
+    range.size = VK_WHOLE_SIZE;
+    vkInvalidateMappedMemoryRanges(dev->device, 1, &range);
+  }
+
+  memcpy(frame_copy, target->pixels, (size_t)extent.width * extent.height * 4);
+
+  // Drawing the image again resets its timestamp before overwriting the
+  // staging buffer: an unchanged timestamp means an untorn copy.
+  if (get_timestamp(dev, index) != timestamp) {
+    capture_drop_frame();
+    return;
+  }
+
+  capture_write_frame(frame_copy, (ptrdiff_t)extent.width * 4);
+}
+
+void capture_vk_read(SulfurDevice *dev) {
+  // Queries are only valid once every command buffer ran.
+  if (!capture_is_running() || ++polled_frames <= 2 * image_count) {
+    return;
+  }
+
+  for (;;) {
+    uint32_t oldest = target_count;
+    uint64_t oldest_timestamp = 0;
+    for (uint32_t i = 0; i < target_count; i++) {
+      const uint64_t timestamp = get_timestamp(dev, i);
+      if (timestamp > last_timestamp &&
+          (oldest == target_count || timestamp < oldest_timestamp)) {
+        oldest = i;
+        oldest_timestamp = timestamp;
+      }
+    }
+
+    if (oldest == target_count) {
+      return;
+    }
+
+    last_timestamp = oldest_timestamp;
+    write_target(dev, oldest, oldest_timestamp);
+  }
+}
+
+void capture_vk_quit(SulfurDevice *dev) {
+  if (!capture_is_running()) {
+    return;
+  }
+
+  capture_vk_read(dev);
+
+  for (uint32_t i = 0; i < target_count; i++) {
+    destroy_target(dev, &targets[i]);
+  }
+  target_count = 0;
+
+  vkDestroyPipeline(dev->device, pipelines[0], NULL);
+  vkDestroyPipeline(dev->device, pipelines[1], NULL);
+  vkDestroyRenderPass(dev->device, render_pass, NULL);
+  vkDestroyQueryPool(dev->device, query_pool, NULL);
+
+  free(frame_copy);
+  frame_copy = NULL;
+
+  capture_quit();
+}
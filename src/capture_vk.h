@@ -0,0 +1,38 @@
+#pragma once
+#include <sulfur/device.h>
+#include <sulfur/swapchain.h>
+#include <vulkan/vulkan.h>
+
+/**
+ * Start capturing at the swapchain size if asked for, with an offscreen
+ * target and a host-visible staging buffer per swapchain image.
+ */
+void capture_vk_init(SulfurDevice *dev, const SulfurSwapchain *swapchain);
+
+/**
+ * Create the pipelines drawing into capture targets from the `count`
+ * sprite and ghost pipeline descriptions.
+ */
+void capture_vk_create_pipelines(SulfurDevice *dev, uint32_t count,
+                                 const VkGraphicsPipelineCreateInfo *infos,
+                                 VkPipelineCache pipeline_cache);
+
+/**
+ * Record drawing the frame again into the target of swapchain image
+ * `index` and copying it to its staging buffer.
+ */
+void capture_vk_record(VkCommandBuffer cmd_buf, uint32_t index,
+                       VkDescriptorSet descriptor_set,
+                       const VkClearValue *clear_color);
+
+/**
+ * Write out frames the GPU finished copying, oldest first, without
+ * waiting for any.
+ */
+void capture_vk_read(SulfurDevice *dev);
+
+/**
+ * Write out the last frames and destroy the capture targets.
+ * The device must be idle.
+ */
+void capture_vk_quit(SulfurDevice *dev);
@@ -0,0 +1,94 @@
+#include "env.h"
+
+#include <stdlib.h>
+
+#include "scene.h"
+#include "world.h"
+
+// Sky behind the sprites, as the GPU renderers clear to.
+static const float kEnvSkyRed = 0.53F;
+static const float kEnvSkyGreen = 0.81F;
+static const float kEnvSkyBlue = 0.92F;
+
+struct Env {
+  int count;
+  World worlds[];
+};
+
+static void observe(const World *world, float *obs) {
+  const Pipe *next = world_get_next_pipe(world);
+
+  obs[0] = world->bird_y;
+  obs[1] = world->speed_y;
+  obs[2] = next != NULL ? next->x : kScreenRight;
+  obs[3] = next != NULL ? next->height : 0.F;
+  obs[4] = next != NULL ? next->gap : 0.F;
+}
+
+Env *env_create(const int count) {
+  if (count < 1) {
+    return NULL;
+  }
+
+  Env *env = malloc(sizeof(Env) + sizeof(World) * count);
+  if (env == NULL) {
+    return NULL;
+  }
+
+  env->count = count;
+  env_reset(env, NULL, NULL);
+  return env;
+}
+
+void env_destroy(Env *env) { free(env); }
+
+void env_reset(Env *env, const uint64_t *seeds, float *obs_out) {
+  for (int i = 0; i < env->count; i++) {
+    world_seed(&env->worlds[i], seeds != NULL ? seeds[i] : (uint64_t)i);
+    if (obs_out != NULL) {
+      observe(&env->worlds[i], &obs_out[i * kEnvObservationSize]);
+    }
+  }
+}
+
+void env_step(Env *env, const uint8_t *actions, float *obs_out,
+              float *reward_out, uint8_t *done_out) {
+  for (int i = 0; i < env->count; i++) {
+    World *world = &env->worlds[i];
+
+    if (actions[i]) {
+      world_thrust(world);
+    }
+
+    for (int j = 0; j < kEnvStepTicks && world->state == WORLD_PLAYING; j++) {
+      world_step(world, kWorldTimeStep);
+    }
+
+    // Nothing left to control once the bird has hit something.
+    const int done = world->state != WORLD_PLAYING;
+    if (done) {
+      // Start the clock over as `world_init` does, so that a flap just
+      // before the crash does not hold back flaps of the next episode.
+      world->time = 0.F;
+      world->last_thrust = -kThrustDelay;
+      world_reset(world);
+    }
+
+    reward_out[i] = done ? kEnvDeathReward : kEnvAliveReward;
+    done_out[i] = (uint8_t)done;
+    observe(world, &obs_out[i * kEnvObservationSize]);
+  }
+}
+
+void env_render(const Env *env, const RasterTexture *atlas, uint8_t *frames,
+                const int width, const int height) {
+  const uint8_t sky = raster_luma(kEnvSkyRed, kEnvSkyGreen, kEnvSkyBlue);
+
+  for (int i = 0; i < env->count; i++) {
+    Sprite sprites[kNumSprites];
+    scene_build(&env->worlds[i], sprites);
+
+    raster_draw_gray(atlas, sprites, kNumSprites, sky,
+                     &frames[(size_t)i * width * height], width, height);
+  }
+}
@@ -0,0 +1,57 @@
+#ifndef FLAP_ENV_H
+#define FLAP_ENV_H
+
+#include <stdint.h>
+
+#include "raster.h"
+
+// Physics steps per environment step.
+#define kEnvStepTicks 4
+
+// Floats per observation: bird y, bird vertical speed,
+// then x, height and gap of the next pipe.
+#define kEnvObservationSize 5
+
+// Reward for every step survived, and for the step that ends an episode.
+#define kEnvAliveReward 1.F
+#define kEnvDeathReward -1.F
+
+/**
+ * A batch of independent games, stepped together.
+ * Buffers passed in are owned by the caller and laid out one environment
+ * after the other; nothing is copied besides writing the outputs.
+ */
+typedef struct Env Env;
+
+/**
+ * Create `count` environments, seeded with their index.
+ * Return NULL if out of memory.
+ */
+Env *env_create(int count);
+
+void env_destroy(Env *env);
+
+/**
+ * Start every environment over from `seeds` (one per environment, as for
+ * `world_seed`), or from their index if NULL.
+ * Write first observations to `obs_out` if not NULL.
+ */
+void env_reset(Env *env, const uint64_t *seeds, float *obs_out);
+
+/**
+ * Flap where `actions` is non-zero, then advance every environment by
+ * `kEnvStepTicks` physics steps.
+ * An environment whose bird crashed reports done and starts over right
+ * away: its observation is then the first one of the next episode.
+ */
+void env_step(Env *env, const uint8_t *actions, float *obs_out,
+              float *reward_out, uint8_t *done_out);
+
+/**
+ * Draw every environment into `frames`, `width` x `height` bytes each,
+ * in grayscale with `atlas` from `raster_texture_init`.
+ */
+void env_render(const Env *env, const RasterTexture *atlas, uint8_t *frames,
+                int width, int height);
+
+#endif // FLAP_ENV_H
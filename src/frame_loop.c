@@ -0,0 +1,111 @@
+#include "frame_loop.h"
+
+#include <stddef.h>
+
+#include "alloc.h"
+#include "bench.h"
+#include "game.h"
+#include "latency.h"
+#include "netplay.h"
+#include "options.h"
+#include "pacing.h"
+#include "simulation.h"
+#include "snapshot.h"
+#include "window.h"
+
+// Seconds to block for input while nothing moves.
+static const float kIdleTimeout = 0.5F;
+
+static int offline_is_running(const FrameLoop *loop) {
+  return bench_is_running() ||
+         (loop->offline_is_running != NULL && loop->offline_is_running());
+}
+
+static int offline_is_done(const FrameLoop *loop) {
+  return bench_is_done() ||
+         (loop->offline_is_done != NULL && loop->offline_is_done());
+}
+
+void frame_loop_run(const FrameLoop *loop) {
+  pacing_init(options_get()->max_fps, options_get()->just_in_time);
+
+  latency_init(options_get()->latency_report);
+
+  const int threaded = !options_get()->single_thread && simulation_start();
+
+  int idle_frame_presented = 0;
+
+  while (!window_should_close() && !offline_is_done(loop)) {
+    // Once the frozen frame is on screen, block until input arrives
+    // instead of re-uploading and presenting the same image.
+    // Benchmarks and batch renders draw every frame.
+    if (idle_frame_presented && snapshot_acquire()->idle &&
+        !window_needs_redraw() && !offline_is_running(loop)) {
+      window_wait_events(kIdleTimeout);
+      if (!threaded) {
+        game_update();
+      }
+      continue;
+    }
+
+    alloc_begin_frame();
+
+    bench_begin_frame();
+
+    pacing_begin_frame();
+
+    // Poll input right before simulating so that it shows up this frame.
+    window_update();
+
+    alloc_set_phase(ALLOC_PHASE_SIMULATE);
+
+    if (!threaded) {
+      game_update();
+    }
+
+    alloc_set_phase(ALLOC_PHASE_RENDER);
+
+    // Render the latest completed simulation step.
+    const Snapshot *snapshot = snapshot_acquire();
+
+    loop->draw();
+
+    pacing_end_frame();
+
+    bench_frame_submitted();
+
+    latency_frame_submitted(snapshot);
+
+    alloc_set_phase(ALLOC_PHASE_PRESENT);
+
+    loop->present();
+
+    pacing_frame_presented();
+
+    latency_frame_presented();
+
+    if (loop->frame_presented != NULL) {
+      loop->frame_presented();
+    }
+
+    alloc_end_frame();
+
+    idle_frame_presented = snapshot->idle;
+
+    if (loop->between_frames != NULL) {
+      loop->between_frames();
+    }
+  }
+
+  simulation_stop();
+
+  latency_report();
+
+  bench_report();
+
+  alloc_report();
+
+  netplay_report();
+
+  netplay_quit();
+}
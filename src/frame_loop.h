@@ -0,0 +1,46 @@
+#ifndef FLAP_FRAME_LOOP_H
+#define FLAP_FRAME_LOOP_H
+
+/**
+ * What a backend does in each frame of the shared loop.
+ * Optional hooks are NULL when a backend has nothing to do there.
+ */
+typedef struct FrameLoop {
+  /**
+   * Draw and submit the latest snapshot.
+   */
+  void (*draw)(void);
+
+  /**
+   * Hand the frame to the display.
+   */
+  void (*present)(void);
+
+  /**
+   * Optional: read back GPU results once the frame was presented, still
+   * counted as part of the frame.
+   */
+  void (*frame_presented)(void);
+
+  /**
+   * Optional: slow work between frames, outside of the measured frame so
+   * that it does not delay sampling.
+   */
+  void (*between_frames)(void);
+
+  /**
+   * Optional: whether an offline render draws every frame, and whether
+   * it is over.
+   */
+  int (*offline_is_running)(void);
+  int (*offline_is_done)(void);
+} FrameLoop;
+
+/**
+ * Play until the window closes or a benchmark ends: pace frames, poll
+ * input, simulate on the render thread or its own, and draw through
+ * `loop`. Then stop the simulation and print the reports asked for.
+ */
+void frame_loop_run(const FrameLoop *loop);
+
+#endif // FLAP_FRAME_LOOP_H
@@ -3,271 +3,187 @@
 #include <stddef.h>
 #include <time.h>
 
-#include "xoroshiro.h"
-
-#include "sprite.h"
+#include "bench.h"
+#include "ghost.h"
+#include "input.h"
+#include "latency.h"
+#include "netplay.h"
+#include "options.h"
+#include "scene.h"
+#include "snapshot.h"
 #include "window.h"
+#include "world.h"
 
-// Vulkan coordinate system.
-static const float kScreenTop = -1.F;
-static const float kScreenBottom = 1.F;
-static const float kScreenHeight = 2.F;
-static const float kScreenLeft = -1.F;
-static const float kScreenRight = 1.F;
-static const float kScreenWidth = 2.F;
-
-// Physics
-static const float kGravity = 2.F;
-static const float kThrust = -0.75F;
-static const float kThrustDelay = 0.1F;
-static const float kScrollSpeed = -0.24F;
-static const float kFallSpeed = 0.1F;
-
-// Increase difficulty over time:
-// Game can't last more than 2 minutes.
-static const float kDeadline = 120.F;
-
-// Bird
-static const float kBirdX = -0.75F;
-static const float kBirdY = -0.5F;
-static const float kBirdWidth = 0.08F;
-static const float kBirdHeight = 0.14F;
-static const float kBirdTextureX = 0.F;
-static const float kBirdTextureY = 0.F;
-static const float kBirdTextureWidth = 32.F;
-static const float kBirdTextureHeight = 32.F;
-
-// Pipes
-static const float kPipeWidth = 0.12F;
-static const float kMinPipeHeight = 0.25F;
-static const float kMaxPipeHeight = 1.F;
-static const float kInitialPipeGap = 0.64F;
-static const float kPipeStep = 0.5F;
-
-static const float kPipeHeadHeight = 16.F / 32.F;
-static const float kPipeHeadTextureX = 64.F;
-static const float kPipeHeadTextureY = 0.F;
-static const float kPipeHeadTextureWidth = 32.F;
-static const float kPipeHeadTextureHeight = 16.F;
-
-static const float kPipeBodyTextureX = 102.F;
-static const float kPipeBodyTextureY = 0.F;
-static const float kPipeBodyTextureWidth = 20.F;
-static const float kPipeBodyTextureHeight = 32.F;
-
-// kPipeBodyWidth = kPipeBodyTextureWidth / kPipeHeadTextureWidth * kPipeWidth;
-static const float kPipeBodyWidth = 0.075F;
-
-// kPipeBodyX = (kPipeWidth - kPipeBodyWidth) / 2.F;
-static const float kPipeBodyX = 0.0225F;
-
-static uint64_t random_generator_state[2] = {0};
-
-typedef enum { STATE_PLAYING, STATE_FALLING, STATE_GAMEOVER } GameState;
-
-static GameState game_state = STATE_PLAYING;
+// Drop simulation time after long hitches instead of catching up.
+static const float kMaxFrameTime = 0.25F;
 
-static int pause = 0;
+// Run-ahead hides a frame or two of latency, more only mispredicts.
+static const int kMaxRunAhead = 4;
 
-static float speed_x = 0.F;
-static float speed_y = 0.F;
+static World world = {0};
 
-static float last_time = 0.F;
-static float last_thrust = 0.F;
+// Seed of every game when the course is pinned, see `ghost.h`.
+static uint64_t course_seed = 0;
+static int course_pinned = 0;
+
+static int pause = 0;
 
-static Sprite *bird = NULL;
+// Steps drawn ahead of the simulation, see `--run-ahead`.
+static int run_ahead = 0;
 
-static Sprite *pipes[kNumSprites] = {NULL};
-static int next_pipe = 0;
-static float pipe_gap = 0.F;
+// Time the simulation has advanced to.
+static float sim_time = 0.F;
 
 /**
- * Reset game state.
+ * Hand the current state over to the renderer.
  */
-static void game_reset() {
-  game_state = STATE_PLAYING;
-
-  pipe_gap = kInitialPipeGap;
-
-  sprite_set_x(bird, kBirdX);
-  sprite_set_y(bird, kBirdY);
-
-  for (int i = 0; i < kSpritesPerPipe * kNumPipes; i += 4) {
-    xoroshiro128plus(random_generator_state);
-
-    const float x = (i / kSpritesPerPipe) * kPipeStep;
-    const float h = kMinPipeHeight + (float)random_generator_state[0] /
-                                         UINT64_MAX *
-                                         (kMaxPipeHeight - kMinPipeHeight);
-
-    // Top pipe body
-    sprite_set_x(pipes[i], x + kPipeBodyX);
-    sprite_set_y(pipes[i], kScreenTop);
-    sprite_set_w(pipes[i], kPipeBodyWidth);
-    sprite_set_h(pipes[i], h);
-    sprite_set_th(pipes[i], 2 * h / kPipeWidth);
-
-    // Top pipe head
-    sprite_set_x(pipes[i + 1], x);
-    sprite_set_y(pipes[i + 1], kScreenTop + h);
-    sprite_set_w(pipes[i + 1], kPipeWidth);
-    sprite_set_h(pipes[i + 1], kPipeHeadHeight * kPipeWidth);
-
-    // Bottom pipe head
-    sprite_set_x(pipes[i + 2], x);
-    sprite_set_y(pipes[i + 2], kScreenTop + h + pipe_gap);
-    sprite_set_w(pipes[i + 2], kPipeWidth);
-    sprite_set_h(pipes[i + 2], kPipeHeadHeight * kPipeWidth);
-
-    // Bottom pipe body
-    sprite_set_x(pipes[i + 3], x + kPipeBodyX);
-    sprite_set_y(pipes[i + 3],
-                 kScreenTop + h + pipe_gap + kPipeHeadHeight * kPipeWidth);
-    sprite_set_w(pipes[i + 3], kPipeBodyWidth);
-    sprite_set_h(pipes[i + 3],
-                 kScreenHeight - h - kPipeHeadHeight * kPipeWidth);
-    sprite_set_th(pipes[i + 3], 2 * h / kPipeWidth);
+static void publish_snapshot() {
+  Snapshot *snapshot = snapshot_begin();
+
+  if (netplay_is_running()) {
+    netplay_build_scene(snapshot->sprites);
+    snapshot->ghost_count = 0;
+  } else {
+    // Run ahead: draw where the world will be a few steps from now if no
+    // input comes. `world` itself is left alone, so input is applied to
+    // the state the prediction started from and the next one starts over.
+    // Ghosts are predicted over the steps they would race, like `step`.
+    const int steps = pause ? 0 : run_ahead;
+    int ghost_steps = 0;
+    World predicted = world;
+    for (int i = 0; i < steps; i++) {
+      ghost_steps += predicted.state == WORLD_PLAYING;
+      world_step(&predicted, kWorldTimeStep);
+    }
+    scene_build(&predicted, snapshot->sprites);
+    snapshot->ghost_count =
+        ghost_get_positions(snapshot->ghost_ys, ghost_steps);
   }
-  next_pipe = 0;
 
-  speed_x = 0.F;
-  speed_y = 0.F;
+  snapshot->idle = game_is_idle();
+
+  snapshot_publish();
 }
 
 /**
  * Initialize game resources.
  */
 void game_init() {
-  random_generator_state[0] = time(NULL) | 0xffe792a1 << 31;
-  random_generator_state[1] = time(NULL) | 0xbffae98d << 31;
-
-  bird = sprite_new(kBirdTextureX, kBirdTextureY, kBirdTextureWidth,
-                    kBirdTextureHeight);
-  sprite_set_w(bird, kBirdWidth);
-  sprite_set_h(bird, kBirdHeight);
-
-  for (int i = 0; i < kSpritesPerPipe * kNumPipes; i += 4) {
-    // Top pipe body
-    pipes[i] = sprite_new(kPipeBodyTextureX, kPipeBodyTextureY,
-                          kPipeBodyTextureWidth, kPipeBodyTextureHeight);
-
-    // Top pipe head
-    pipes[i + 1] = sprite_new(kPipeHeadTextureX, kPipeHeadTextureY,
-                              kPipeHeadTextureWidth, kPipeHeadTextureHeight);
-
-    // Bottom pipe head
-    pipes[i + 2] = sprite_new(kPipeHeadTextureX, kPipeHeadTextureY,
-                              kPipeHeadTextureWidth, kPipeHeadTextureHeight);
-
-    // Bottom pipe body
-    pipes[i + 3] = sprite_new(kPipeBodyTextureX, kPipeBodyTextureY,
-                              kPipeBodyTextureWidth, kPipeBodyTextureHeight);
-  }
+  // Benchmarks replay the same game every time.
+  course_seed = bench_is_running() ? 0 : (uint64_t)time(NULL);
 
-  game_reset();
-}
+  ghost_init();
+  course_pinned = ghost_get_seed(&course_seed);
+
+  world_seed(&world, course_seed);
 
-static void scroll_pipes(const float dt) {
-  for (int i = 0; i < kSpritesPerPipe * kNumPipes; i += 4) {
-    const float new_x = sprite_get_x(pipes[i + 1]) + kScrollSpeed * dt;
+  netplay_init();
 
-    sprite_set_x(pipes[i], new_x + kPipeBodyX);
-    sprite_set_x(pipes[i + 1], new_x);
-    sprite_set_x(pipes[i + 2], new_x);
-    sprite_set_x(pipes[i + 3], new_x + kPipeBodyX);
+  run_ahead = options_get()->run_ahead;
+  if (run_ahead < 0) {
+    run_ahead = 0;
+  } else if (run_ahead > kMaxRunAhead) {
+    run_ahead = kMaxRunAhead;
   }
+
+  sim_time = window_get_time();
+
+  publish_snapshot();
 }
 
 /**
- * Update physics.
+ * Apply an input event at the current simulation time.
  */
-void game_update() {
-  const float now = window_get_time();
-  const float dt = now - last_time;
-  last_time = now;
+static void apply_input(const InputEvent *event) {
+  switch (event->type) {
+  case INPUT_THRUST:
+    if (pause) {
+      break;
+    }
+    if (world.state == WORLD_GAMEOVER) {
+      // Start over, on the same course if it is pinned.
+      if (course_pinned) {
+        world_seed(&world, course_seed);
+      } else {
+        world_reset(&world);
+      }
+      ghost_start();
+    } else if (world_thrust(&world)) {
+      ghost_record_flap(&world);
+      latency_input_applied(event->time, window_get_time(),
+                            snapshot_next_sequence());
+    }
+    break;
+  case INPUT_PAUSE:
+    pause = !pause;
+    break;
+  default:
+    break;
+  }
+}
 
+/**
+ * Advance physics by `dt` unless paused.
+ */
+static void step(const float dt) {
   if (pause) {
-    if (window_get_pause()) {
-      pause = 0;
-    }
     return;
-  } else if (window_get_pause()) {
-    pause = 1;
   }
 
-  switch (game_state) {
-  case STATE_PLAYING:
-    speed_y += kGravity * dt;
+  const WorldState state = world.state;
+  world_step(&world, dt);
 
-    if (window_get_thrust() && now - last_thrust > kThrustDelay) {
-      speed_y += kThrust;
-      last_thrust = now;
-    }
-
-    scroll_pipes(dt);
-
-    // Set pipes back to the far right
-    if (sprite_get_x(pipes[next_pipe]) < kScreenLeft - kPipeWidth) {
-      float far_away = kScreenRight;
-
-      pipe_gap = kInitialPipeGap - (now / kDeadline) * kInitialPipeGap;
-
-      xoroshiro128plus(random_generator_state);
-      float new_height = kMinPipeHeight + (float)random_generator_state[0] /
-                                              UINT64_MAX *
-                                              (kMaxPipeHeight - kMinPipeHeight);
+  // Ghosts race the player: they stop when the player crashes.
+  if (state == WORLD_PLAYING) {
+    ghost_step(&world, dt);
+  }
+  if (state != WORLD_GAMEOVER && world.state == WORLD_GAMEOVER) {
+    ghost_record_end();
+  }
+}
 
-      // Top pipe body
-      sprite_set_x(pipes[next_pipe], far_away);
-      sprite_set_h(pipes[next_pipe], new_height);
-      sprite_set_th(pipes[next_pipe], 2 * new_height / kPipeWidth);
+int game_is_idle() {
+  // The other player may be flying.
+  if (netplay_is_running()) {
+    return 0;
+  }
+  return pause || world.state == WORLD_GAMEOVER;
+}
 
-      // Top pipe head
-      sprite_set_x(pipes[next_pipe + 1], far_away);
-      sprite_set_y(pipes[next_pipe + 1], kScreenTop + new_height);
+/**
+ * Update physics.
+ * Run fixed steps up to the current time, splitting a step
+ * wherever an input event happened.
+ */
+void game_update() {
+  const float now = window_get_time();
 
-      // Bottom pipe head
-      sprite_set_x(pipes[next_pipe + 2], far_away);
-      sprite_set_y(pipes[next_pipe + 2], kScreenTop + new_height + pipe_gap);
+  if (netplay_is_running()) {
+    netplay_update(now);
+    publish_snapshot();
+    return;
+  }
 
-      // Bottom pipe body
-      sprite_set_x(pipes[next_pipe + 3], far_away);
-      sprite_set_y(pipes[next_pipe + 3], kScreenTop + new_height + pipe_gap +
-                                             kPipeHeadHeight * kPipeWidth);
-      sprite_set_h(pipes[next_pipe + 3],
-                   kScreenHeight - new_height - kPipeHeadHeight * kPipeWidth);
-      sprite_set_th(pipes[next_pipe + 3], 2 * new_height / kPipeWidth);
+  if (now - sim_time > kMaxFrameTime) {
+    sim_time = now - kMaxFrameTime;
+  }
 
-      next_pipe = (next_pipe + kSpritesPerPipe) % (kSpritesPerPipe * kNumPipes);
+  while (sim_time + kWorldTimeStep <= now) {
+    const float step_end = sim_time + kWorldTimeStep;
+
+    const InputEvent *event = NULL;
+    while ((event = input_peek()) != NULL && event->time < step_end) {
+      if (event->time > sim_time) {
+        step(event->time - sim_time);
+        sim_time = event->time;
+      }
+      apply_input(event);
+      input_pop();
     }
 
-    if (sprite_intersect(bird, pipes[next_pipe]) ||
-        sprite_intersect(bird, pipes[next_pipe + 1]) ||
-        sprite_intersect(bird, pipes[next_pipe + 2]) ||
-        sprite_intersect(bird, pipes[next_pipe + 3]) ||
-        sprite_get_y(bird) < kScreenTop) {
-      game_state = STATE_FALLING;
-      speed_x = -kFallSpeed;
-      speed_y = kFallSpeed;
-    } else if (sprite_get_y(bird) > kScreenBottom) {
-      game_state = STATE_GAMEOVER;
-    }
-    break;
-  case STATE_FALLING:
-    speed_y += kGravity * dt;
-    if (sprite_get_y(bird) > kScreenBottom) {
-      game_state = STATE_GAMEOVER;
-    }
-    break;
-  case STATE_GAMEOVER:
-    if (window_get_thrust()) {
-      game_reset();
-    }
-    break;
-  default:
-    break;
+    step(step_end - sim_time);
+    sim_time = step_end;
   }
 
-  sprite_set_x(bird, sprite_get_x(bird) + speed_x * dt);
-  sprite_set_y(bird, sprite_get_y(bird) + speed_y * dt);
+  publish_snapshot();
 }
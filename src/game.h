@@ -5,4 +5,10 @@ void game_init();
 
 void game_update();
 
+/**
+ * Whether the world is frozen: paused or game over.
+ * Nothing needs to be redrawn until input arrives.
+ */
+int game_is_idle();
+
 #endif // FLAP_GAME_H
@@ -0,0 +1,263 @@
+#include "ghost.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "alloc.h"
+#include "options.h"
+#include "window.h"
+
+// Flaps recorded per run. Games end by `kDeadline` and flaps are at
+// least `kThrustDelay` apart.
+#define kMaxRecordedFlaps 2048
+
+typedef enum { GHOST_FLYING, GHOST_CRASHED } GhostState;
+
+/**
+ * Every run loaded, one array per field so that stepping them all
+ * streams through memory.
+ */
+static int count = 0;
+static float *flap_times = NULL; // Flaps of every run, run after run
+static int *flap_ends = NULL;    // Past the last flap of each run
+static int *next_flaps = NULL;   // Next flap of each run to play
+static float *ys = NULL;         // Top of each bird
+static float *speeds = NULL;     // Vertical speed of each bird
+static uint8_t *states = NULL;
+
+// Play time the ghosts were stepped to.
+static float play_time = 0.F;
+
+// Course every game is played on, when pinned.
+static uint64_t course_seed = 0;
+static int course_pinned = 0;
+
+// Flaps of the run being played, when recording.
+static float recorded[kMaxRecordedFlaps];
+static int recorded_count = 0;
+
+/**
+ * Read runs of the first run's course from `path`.
+ */
+static void load(const char *path) {
+#ifdef _WIN32
+  FILE *file = NULL;
+  fopen_s(&file, path, "r");
+#else
+  FILE *file = fopen(path, "re");
+#endif
+  if (file == NULL) {
+    window_fail_with_error("Could not open the ghost file!");
+    return;
+  }
+
+  int capacity = 0;
+  int flap_capacity = 0;
+  int flap_count = 0;
+
+  unsigned long long seed = 0;
+  int flaps = 0;
+  while (count < kMaxGhosts &&
+         fscanf(file, "%llu %d", &seed, &flaps) == 2 && flaps >= 0) {
+    if (count == 0) {
+      course_seed = seed;
+    }
+
+    if (flap_count + flaps > flap_capacity) {
+      flap_capacity = 2 * (flap_count + flaps);
+      flap_times = realloc(flap_times, sizeof(float) * flap_capacity);
+    }
+    if (count == capacity) {
+      capacity = capacity > 0 ? 2 * capacity : 64;
+      flap_ends = realloc(flap_ends, sizeof(int) * capacity);
+    }
+    if (flap_times == NULL || flap_ends == NULL) {
+      window_fail_with_error("Out of memory for ghosts!");
+      return;
+    }
+
+    int read = 0;
+    while (read < flaps &&
+           fscanf(file, "%f", &flap_times[flap_count + read]) == 1) {
+      read++;
+    }
+    if (read < flaps) {
+      break;
+    }
+
+    // Other courses do not race this one.
+    if (seed == course_seed) {
+      flap_count += flaps;
+      flap_ends[count++] = flap_count;
+    }
+  }
+  fclose(file);
+
+  if (count == 0) {
+    return;
+  }
+
+  next_flaps = malloc(sizeof(int) * count);
+  ys = malloc(sizeof(float) * count);
+  speeds = malloc(sizeof(float) * count);
+  states = malloc(count);
+  if (next_flaps == NULL || ys == NULL || speeds == NULL || states == NULL) {
+    window_fail_with_error("Out of memory for ghosts!");
+  }
+}
+
+void ghost_init() {
+  const char *path = options_get()->ghosts;
+  if (path != NULL) {
+    load(path);
+  }
+
+  // Ghosts only make sense on their own course, and so do recordings.
+  course_pinned = count > 0 || options_get()->record != NULL;
+
+  ghost_start();
+}
+
+int ghost_get_seed(uint64_t *seed) {
+  if (!course_pinned) {
+    return 0;
+  }
+
+  // A first recording keeps the course it was given.
+  if (count > 0) {
+    *seed = course_seed;
+  } else {
+    course_seed = *seed;
+  }
+  return 1;
+}
+
+void ghost_start() {
+  for (int i = 0; i < count; i++) {
+    next_flaps[i] = i > 0 ? flap_ends[i - 1] : 0;
+    ys[i] = kBirdY;
+    speeds[i] = 0.F;
+    states[i] = GHOST_FLYING;
+  }
+  play_time = 0.F;
+
+  recorded_count = 0;
+}
+
+void ghost_step(const World *world, const float dt) {
+  if (count == 0) {
+    return;
+  }
+
+  // Boxes of the pipes in the birds' column: every bird has the same x.
+  Box boxes[kNumPipes * kSpritesPerPipe];
+  int box_count = 0;
+  for (int i = 0; i < kNumPipes; i++) {
+    Box pipe_boxes[kSpritesPerPipe];
+    world_get_pipe_boxes(&world->pipes[i], pipe_boxes);
+    for (int j = 0; j < kSpritesPerPipe; j++) {
+      if (pipe_boxes[j].left < kBirdX + kBirdWidth &&
+          kBirdX < pipe_boxes[j].right) {
+        boxes[box_count++] = pipe_boxes[j];
+      }
+    }
+  }
+
+  // Flaps split the step where they happened, like the player's flaps
+  // split `world_step`, so that the flight is the one recorded.
+  const float start = play_time;
+  const float end = world->play_time;
+  play_time = end;
+
+  for (int i = 0; i < count; i++) {
+    if (states[i] != GHOST_FLYING) {
+      continue;
+    }
+
+    // Integrated as `world_step` does, over the same step lengths when
+    // there is no flap: play times are too coarse to take differences of.
+    float done = 0.F;
+    float speed = speeds[i];
+    float top = ys[i];
+    while (next_flaps[i] < flap_ends[i] && flap_times[next_flaps[i]] < end) {
+      const float at = flap_times[next_flaps[i]] - start;
+      if (at > done) {
+        speed += kGravity * (at - done);
+        top += speed * (at - done);
+        done = at;
+      }
+      speed += kThrust;
+      next_flaps[i]++;
+    }
+    speed += kGravity * (dt - done);
+    top += speed * (dt - done);
+
+    const float bottom = top + kBirdHeight;
+    speeds[i] = speed;
+    ys[i] = top;
+
+    int crashed = top < kScreenTop || top > kScreenBottom;
+    for (int j = 0; j < box_count; j++) {
+      crashed |= top < boxes[j].bottom && boxes[j].top < bottom;
+    }
+    if (crashed) {
+      states[i] = GHOST_CRASHED;
+    }
+  }
+}
+
+void ghost_record_flap(const World *world) {
+  if (options_get()->record != NULL && recorded_count < kMaxRecordedFlaps) {
+    recorded[recorded_count++] = world->play_time;
+  }
+}
+
+void ghost_record_end() {
+  const char *path = options_get()->record;
+  if (path == NULL) {
+    return;
+  }
+
+  // The C library buffers the file on the heap.
+  alloc_skip_frame();
+
+#ifdef _WIN32
+  FILE *file = NULL;
+  fopen_s(&file, path, "a");
+#else
+  FILE *file = fopen(path, "ae");
+#endif
+  if (file == NULL) {
+    window_fail_with_error("Could not open the recording file!");
+    return;
+  }
+
+  fprintf(file, "%llu %d", (unsigned long long)course_seed, recorded_count);
+  for (int i = 0; i < recorded_count; i++) {
+    // Enough digits to read back the same float.
+    fprintf(file, " %.9g", recorded[i]);
+  }
+  fprintf(file, "\n");
+  fclose(file);
+
+  recorded_count = 0;
+}
+
+int ghost_get_positions(float *out, const int steps) {
+  int flying = 0;
+  for (int i = 0; i < count; i++) {
+    if (states[i] != GHOST_FLYING) {
+      continue;
+    }
+
+    // Without flaps, as the world is predicted when running ahead
+    float speed = speeds[i];
+    float top = ys[i];
+    for (int j = 0; j < steps; j++) {
+      speed += kGravity * kWorldTimeStep;
+      top += speed * kWorldTimeStep;
+    }
+    out[flying++] = top;
+  }
+  return flying;
+}
@@ -0,0 +1,55 @@
+#ifndef FLAP_GHOST_H
+#define FLAP_GHOST_H
+
+#include <stdint.h>
+
+#include "world.h"
+
+/**
+ * Ghost racing.
+ * `--ghosts=FILE` loads recorded runs of one course and plays them back as
+ * translucent birds racing the player, and `--record=FILE` appends every
+ * run played to such a file. Either one pins the course: every game is
+ * seeded the same. A run is written as its seed, its number of flaps and
+ * the play time of each flap, all separated by white space.
+ *
+ * Ghosts share the player's course, so only their birds are simulated,
+ * all together and against the player's pipes.
+ */
+void ghost_init(void);
+
+/**
+ * Replace `seed` by the one of the pinned course, if any.
+ * Return whether games all use this seed.
+ */
+int ghost_get_seed(uint64_t *seed);
+
+/**
+ * Start every ghost and a new recording over with a new game.
+ */
+void ghost_start(void);
+
+/**
+ * Advance every ghost by `dt`, after `world` itself was.
+ * Flaps split the step at the time they were recorded.
+ */
+void ghost_step(const World *world, float dt);
+
+/**
+ * Record a flap of the player.
+ */
+void ghost_record_flap(const World *world);
+
+/**
+ * The player's game is over: save the recording.
+ */
+void ghost_record_end(void);
+
+/**
+ * Write the top of each ghost bird still flying, up to `kMaxGhosts`,
+ * where it will be `steps` fixed steps from now if it does not flap.
+ * Return how many.
+ */
+int ghost_get_positions(float *ys, int steps);
+
+#endif // FLAP_GHOST_H
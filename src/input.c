@@ -0,0 +1,45 @@
+#include "input.h"
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+// Must be a power of two.
+#define kInputQueueSize 64
+
+/**
+ * Lock-free single producer, single consumer ring buffer.
+ * Indices grow forever and wrap through the mask.
+ */
+static InputEvent queue[kInputQueueSize];
+static atomic_uint head = 0; // Next event to read, owned by the consumer
+static atomic_uint tail = 0; // Next slot to write, owned by the producer
+
+int input_push(InputEventType type, float time) {
+  const unsigned int t = atomic_load_explicit(&tail, memory_order_relaxed);
+  const unsigned int h = atomic_load_explicit(&head, memory_order_acquire);
+
+  if (t - h == kInputQueueSize) {
+    return 0;
+  }
+
+  queue[t & (kInputQueueSize - 1)].type = type;
+  queue[t & (kInputQueueSize - 1)].time = time;
+
+  atomic_store_explicit(&tail, t + 1, memory_order_release);
+  return 1;
+}
+
+const InputEvent *input_peek(void) {
+  const unsigned int h = atomic_load_explicit(&head, memory_order_relaxed);
+  const unsigned int t = atomic_load_explicit(&tail, memory_order_acquire);
+
+  if (h == t) {
+    return NULL;
+  }
+  return &queue[h & (kInputQueueSize - 1)];
+}
+
+void input_pop(void) {
+  const unsigned int h = atomic_load_explicit(&head, memory_order_relaxed);
+  atomic_store_explicit(&head, h + 1, memory_order_release);
+}
@@ -0,0 +1,33 @@
+#ifndef FLAP_INPUT_H
+#define FLAP_INPUT_H
+
+typedef enum { INPUT_THRUST, INPUT_PAUSE } InputEventType;
+
+/**
+ * An input event stamped with the time it happened,
+ * on the same clock as `window_get_time`.
+ */
+typedef struct InputEvent {
+  InputEventType type;
+  float time;
+} InputEvent;
+
+/**
+ * Queue an event.
+ * Must only be called from the thread handling window events.
+ * Return 0 if the queue is full and the event was dropped.
+ */
+int input_push(InputEventType type, float time);
+
+/**
+ * Return the oldest queued event without removing it, or NULL.
+ * Must only be called from the thread running the game.
+ */
+const InputEvent *input_peek(void);
+
+/**
+ * Remove the oldest queued event.
+ */
+void input_pop(void);
+
+#endif // FLAP_INPUT_H
@@ -0,0 +1,185 @@
+#include "latency.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+
+#include "window.h"
+
+// 1 ms buckets, the last one collects everything above.
+#define kLatencyBuckets 100
+
+// Inputs applied in a single frame beyond this are not tracked.
+#define kMaxInputsPerFrame 16
+
+// Must be a power of two.
+#define kAppliedQueueSize 64
+
+typedef struct LatencyStage {
+  double sum;
+  unsigned int count;
+} LatencyStage;
+
+typedef struct AppliedInput {
+  float input_time;
+  float applied_time;
+  unsigned int sequence; // First snapshot showing the input
+} AppliedInput;
+
+static int latency_enabled = 0;
+
+/**
+ * Lock-free single producer, single consumer ring buffer of applied
+ * inputs, from the game to the renderer. Snapshots the renderer never
+ * acquires are overwritten, so inputs cannot travel with them.
+ */
+static AppliedInput applied_queue[kAppliedQueueSize];
+static atomic_uint applied_head = 0; // Owned by the renderer
+static atomic_uint applied_tail = 0; // Owned by the game
+
+static float pending_inputs[kMaxInputsPerFrame];
+static float pending_applied[kMaxInputsPerFrame];
+static unsigned int pending_count = 0;
+
+static float submit_time = 0.F;
+
+static unsigned int histogram[kLatencyBuckets] = {0};
+static LatencyStage input_to_sim = {0};
+static LatencyStage input_to_submit = {0};
+static LatencyStage input_to_present = {0};
+static float max_latency = 0.F;
+
+static void stage_add(LatencyStage *stage, float latency) {
+  stage->sum += latency;
+  stage->count++;
+}
+
+static float stage_mean(const LatencyStage *stage) {
+  return stage->count > 0 ? (float)(stage->sum / stage->count) : 0.F;
+}
+
+void latency_init(int enabled) { latency_enabled = enabled; }
+
+void latency_input_applied(const float input_time, const float applied_time,
+                           const unsigned int sequence) {
+  if (!latency_enabled) {
+    return;
+  }
+
+  const unsigned int t =
+      atomic_load_explicit(&applied_tail, memory_order_relaxed);
+  const unsigned int h =
+      atomic_load_explicit(&applied_head, memory_order_acquire);
+
+  if (t - h == kAppliedQueueSize) {
+    return;
+  }
+
+  AppliedInput *input = &applied_queue[t & (kAppliedQueueSize - 1)];
+  input->input_time = input_time;
+  input->applied_time = applied_time;
+  input->sequence = sequence;
+
+  atomic_store_explicit(&applied_tail, t + 1, memory_order_release);
+}
+
+void latency_frame_submitted(const Snapshot *snapshot) {
+  if (!latency_enabled) {
+    return;
+  }
+
+  // Take every input shown by this snapshot or an earlier one. Each is
+  // taken once, even if the snapshot is drawn again.
+  unsigned int h = atomic_load_explicit(&applied_head, memory_order_relaxed);
+  const unsigned int t =
+      atomic_load_explicit(&applied_tail, memory_order_acquire);
+  while (h != t && pending_count < kMaxInputsPerFrame) {
+    const AppliedInput *input = &applied_queue[h & (kAppliedQueueSize - 1)];
+    if ((int)(input->sequence - snapshot->sequence) > 0) {
+      break;
+    }
+    pending_inputs[pending_count] = input->input_time;
+    pending_applied[pending_count] = input->applied_time;
+    pending_count++;
+    h++;
+  }
+  atomic_store_explicit(&applied_head, h, memory_order_release);
+
+  submit_time = window_get_time();
+}
+
+void latency_frame_presented(void) {
+  if (!latency_enabled || pending_count == 0) {
+    return;
+  }
+
+  const float present_time = window_get_time();
+
+  for (unsigned int i = 0; i < pending_count; i++) {
+    const float latency = present_time - pending_inputs[i];
+
+    stage_add(&input_to_sim, pending_applied[i] - pending_inputs[i]);
+    stage_add(&input_to_submit, submit_time - pending_inputs[i]);
+    stage_add(&input_to_present, latency);
+
+    int bucket = (int)(latency * 1000.F);
+    if (bucket < 0) {
+      bucket = 0;
+    } else if (bucket >= kLatencyBuckets) {
+      bucket = kLatencyBuckets - 1;
+    }
+    histogram[bucket]++;
+
+    if (latency > max_latency) {
+      max_latency = latency;
+    }
+  }
+
+  pending_count = 0;
+}
+
+/**
+ * Return the upper bound in ms of the bucket holding the `p` quantile.
+ */
+static int get_percentile(float p) {
+  const unsigned int target = (unsigned int)(p * input_to_present.count);
+  unsigned int seen = 0;
+  for (int i = 0; i < kLatencyBuckets; i++) {
+    seen += histogram[i];
+    if (seen > target) {
+      return i + 1;
+    }
+  }
+  return kLatencyBuckets;
+}
+
+void latency_report(void) {
+  if (!latency_enabled || input_to_present.count == 0) {
+    return;
+  }
+
+  printf("Input latency over %u inputs (ms):\n", input_to_present.count);
+  printf("  input -> simulation: %.2f mean\n",
+         stage_mean(&input_to_sim) * 1000.F);
+  printf("  input -> submit:     %.2f mean\n",
+         stage_mean(&input_to_submit) * 1000.F);
+  printf("  input -> present:    %.2f mean, %.2f max\n",
+         stage_mean(&input_to_present) * 1000.F, max_latency * 1000.F);
+  printf("  p50 <= %d, p95 <= %d, p99 <= %d\n", get_percentile(0.5F),
+         get_percentile(0.95F), get_percentile(0.99F));
+
+  unsigned int peak = 0;
+  for (int i = 0; i < kLatencyBuckets; i++) {
+    if (histogram[i] > peak) {
+      peak = histogram[i];
+    }
+  }
+
+  for (int i = 0; i < kLatencyBuckets; i++) {
+    if (histogram[i] == 0) {
+      continue;
+    }
+    const int width = (int)(40.F * histogram[i] / peak) + 1;
+    printf("  %3d%s ms %6u %.*s\n", i, i == kLatencyBuckets - 1 ? "+" : " ",
+           histogram[i], width, "****************************************");
+  }
+}
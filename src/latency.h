@@ -0,0 +1,39 @@
+#ifndef FLAP_LATENCY_H
+#define FLAP_LATENCY_H
+
+#include "snapshot.h"
+
+/**
+ * Input-to-photon latency instrumentation.
+ * Thrust events are followed from their OS timestamp
+ * through simulation and submission until present.
+ * All times are on the `window_get_time` clock.
+ */
+void latency_init(int enabled);
+
+/**
+ * An input that happened at `input_time` was applied at `applied_time`
+ * and first shows in the snapshot numbered `sequence`.
+ * Must only be called from the thread running the game.
+ */
+void latency_input_applied(float input_time, float applied_time,
+                           unsigned int sequence);
+
+/**
+ * A frame showing `snapshot` is about to be presented.
+ * Inputs it shows for the first time are tracked until present, even
+ * those of snapshots replaced before the renderer acquired them.
+ */
+void latency_frame_submitted(const Snapshot *snapshot);
+
+/**
+ * The frame was handed to the display.
+ */
+void latency_frame_presented(void);
+
+/**
+ * Print the latency histogram to stdout.
+ */
+void latency_report(void);
+
+#endif // FLAP_LATENCY_H
@@ -0,0 +1,89 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "options.h"
+#include "renderer.h"
+#include "window.h"
+
+// Backends built into this binary, preferred first.
+static const Renderer *const renderers[] = {
+#ifdef FLAP_RENDERER_VULKAN
+    &renderer_vk,
+#endif
+#ifdef FLAP_RENDERER_OPENGL
+    &renderer_gl,
+#endif
+#ifdef FLAP_RENDERER_SOFTWARE
+    &renderer_sw,
+#endif
+};
+
+static const int kNumRenderers = sizeof(renderers) / sizeof(renderers[0]);
+
+// A backend later in the list must beat the best frame time so far by this
+// factor to be picked, so that noise does not override the preference.
+static const double kRendererMargin = 0.75;
+
+/**
+ * Use the backend named on the command line, or else the fastest one that
+ * passes its probe. Probing is skipped when there is nothing to choose.
+ */
+static const Renderer *choose_renderer(void) {
+  const char *name = options_get()->renderer;
+
+  // Only the Vulkan renderer draws batches.
+  if (options_get()->batch > 0) {
+#ifdef FLAP_RENDERER_VULKAN
+    if (name == NULL || strcmp(name, renderer_vk.name) == 0) {
+      return &renderer_vk;
+    }
+#endif
+    window_fail_with_error("Batch renders need the Vulkan renderer!");
+  }
+
+  if (name != NULL) {
+    for (int i = 0; i < kNumRenderers; i++) {
+      if (strcmp(renderers[i]->name, name) == 0) {
+        return renderers[i];
+      }
+    }
+    window_fail_with_error("Unknown renderer!");
+  }
+
+#ifdef FLAP_RENDERER_SOFTWARE
+  // Only the software renderer writes headless captures.
+  if (options_get()->headless != NULL) {
+    return &renderer_sw;
+  }
+#endif
+
+  if (kNumRenderers == 1) {
+    return renderers[0];
+  }
+
+  const Renderer *best = NULL;
+  double best_time = 0.;
+  for (int i = 0; i < kNumRenderers; i++) {
+    const double time = renderers[i]->probe();
+    if (time >= 0. && (best == NULL || time < best_time * kRendererMargin)) {
+      best = renderers[i];
+      best_time = time;
+    }
+  }
+
+  if (best == NULL) {
+    window_fail_with_error("No renderer works on this machine!");
+  }
+  return best;
+}
+
+int main(int argc, char **argv) {
+  options_init(argc, argv);
+
+  const Renderer *renderer = choose_renderer();
+
+  bench_init(renderer->name);
+
+  return renderer->run();
+}
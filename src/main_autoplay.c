@@ -0,0 +1,53 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "autoplay.h"
+#include "options.h"
+#include "world.h"
+
+static const int kDefaultBeamWidth = 256;
+
+/**
+ * Find how long a seed can be survived, playing it with a search.
+ * Exit with 0 when a run reaching the horizon was found, 1 otherwise.
+ */
+int main(int argc, char **argv) {
+  AutoplayConfig config = {(uint64_t)time(NULL), 0, kDefaultBeamWidth,
+                           kDeadline};
+
+  for (int i = 1; i < argc; i++) {
+    const char *value = NULL;
+    if ((value = options_get_value(argv[i], "--seed")) != NULL) {
+      config.seed = strtoull(value, NULL, 10);
+    } else if ((value = options_get_value(argv[i], "--threads")) != NULL) {
+      config.threads = atoi(value);
+    } else if ((value = options_get_value(argv[i], "--beam")) != NULL) {
+      config.beam_width = atoi(value);
+    } else if ((value = options_get_value(argv[i], "--horizon")) != NULL) {
+      config.horizon = (float)atof(value);
+    } else {
+      fprintf(stderr,
+              "Usage: %s [--seed=N] [--threads=N] [--beam=N] "
+              "[--horizon=SECONDS]\n",
+              argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (config.beam_width < 1) {
+    config.beam_width = 1;
+  }
+
+  AutoplayResult result;
+  autoplay_run(&config, &result);
+
+  printf("Seed %llu: survived %.2f s of %.2f s, %s\n",
+         (unsigned long long)config.seed, result.survived, config.horizon,
+         result.winnable ? "winnable" : "no surviving line found");
+  printf("  %llu nodes in %.2f s on %d threads: %.0f nodes/s\n",
+         (unsigned long long)result.nodes, result.seconds, result.threads,
+         result.seconds > 0. ? (double)result.nodes / result.seconds : 0.);
+
+  return result.winnable ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,283 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "microbench.h"
+#include "options.h"
+#include "scene.h"
+#include "sprite.h"
+#include "world_internal.h"
+#include "xoroshiro.h"
+
+static const MicrobenchConfig kDefaultConfig = {11, 0.002, 0.05};
+
+// Rounds over the whole suite, interleaving benchmarks.
+static const int kDefaultRounds = 5;
+
+// Slowdowns below this are never regressions.
+static const double kDefaultThreshold = 0.05;
+
+#define kMaxBenchmarks 32
+#define kMaxRounds 100
+
+/**
+ * Data shared by the benchmarks: the first frame of a game.
+ */
+typedef struct BenchData {
+  World world;
+  Sprite sprites[kNumSprites];
+  uint64_t random_state[2];
+} BenchData;
+
+/**
+ * Call `set` on every sprite of the batch per operation, with values
+ * counting up from `base`.
+ */
+static inline void bench_sprite_set(BenchData *bench, uint64_t iterations,
+                                    void (*set)(Sprite *, float),
+                                    float base) {
+  for (uint64_t i = 0; i < iterations; i++) {
+    const float value = base + (float)(i & 255) * 0.001F;
+    for (int j = 0; j < kNumSprites; j++) {
+      set(&bench->sprites[j], value);
+    }
+    microbench_clobber(bench->sprites);
+  }
+}
+
+static void bench_sprite_set_x(void *data, uint64_t iterations) {
+  bench_sprite_set(data, iterations, sprite_set_x, 0.F);
+}
+
+static void bench_sprite_set_y(void *data, uint64_t iterations) {
+  bench_sprite_set(data, iterations, sprite_set_y, 0.F);
+}
+
+static void bench_sprite_set_w(void *data, uint64_t iterations) {
+  bench_sprite_set(data, iterations, sprite_set_w, 0.1F);
+}
+
+static void bench_sprite_set_h(void *data, uint64_t iterations) {
+  bench_sprite_set(data, iterations, sprite_set_h, 0.1F);
+}
+
+static void bench_sprite_set_th(void *data, uint64_t iterations) {
+  bench_sprite_set(data, iterations, sprite_set_th, 0.1F);
+}
+
+/**
+ * The bird against every pipe sprite.
+ */
+static void bench_sprite_intersect(void *data, uint64_t iterations) {
+  BenchData *bench = data;
+  int hits = 0;
+  for (uint64_t i = 0; i < iterations; i++) {
+    for (int j = kNumPlayers; j < kNumSprites; j++) {
+      hits += sprite_intersect(&bench->sprites[0], &bench->sprites[j]);
+    }
+    microbench_clobber(bench->sprites);
+  }
+  microbench_clobber(&hits);
+}
+
+static void bench_scroll_pipes(void *data, uint64_t iterations) {
+  BenchData *bench = data;
+  for (uint64_t i = 0; i < iterations; i++) {
+    world_scroll_pipes(&bench->world, kWorldTimeStep);
+    microbench_clobber(&bench->world);
+  }
+}
+
+/**
+ * A pipe is recycled every operation.
+ */
+static void bench_recycle_pipes(void *data, uint64_t iterations) {
+  BenchData *bench = data;
+  for (uint64_t i = 0; i < iterations; i++) {
+    bench->world.pipes[bench->world.next_pipe].x = kScreenLeft - 2.F;
+    world_recycle_pipes(&bench->world);
+    microbench_clobber(&bench->world);
+  }
+}
+
+static void bench_xoroshiro128plus(void *data, uint64_t iterations) {
+  BenchData *bench = data;
+  uint64_t sum = 0;
+  for (uint64_t i = 0; i < iterations; i++) {
+    sum += xoroshiro128plus(bench->random_state);
+  }
+  microbench_clobber(&sum);
+}
+
+/**
+ * A whole simulation tick while playing.
+ */
+static void bench_world_step(void *data, uint64_t iterations) {
+  BenchData *bench = data;
+  for (uint64_t i = 0; i < iterations; i++) {
+    if (bench->world.state != WORLD_PLAYING) {
+      world_reset(&bench->world);
+    }
+    if ((i & 31) == 0) {
+      world_thrust(&bench->world);
+    }
+    world_step(&bench->world, kWorldTimeStep);
+    microbench_clobber(&bench->world);
+  }
+}
+
+/**
+ * What `--run-ahead=2` adds to each snapshot: copying the world, two
+ * steps and the sprites of the prediction. Every prediction starts from
+ * the same world, which is not stepped itself.
+ */
+static void bench_run_ahead(void *data, uint64_t iterations) {
+  BenchData *bench = data;
+  if (bench->world.state != WORLD_PLAYING) {
+    world_reset(&bench->world);
+  }
+  for (uint64_t i = 0; i < iterations; i++) {
+    World predicted = bench->world;
+    world_step(&predicted, kWorldTimeStep);
+    world_step(&predicted, kWorldTimeStep);
+    scene_build(&predicted, bench->sprites);
+    microbench_clobber(bench->sprites);
+  }
+}
+
+typedef struct Benchmark {
+  const char *name;
+  MicrobenchFunc func;
+} Benchmark;
+
+static const Benchmark kBenchmarks[] = {
+    {"sprite_set_x", bench_sprite_set_x},
+    {"sprite_set_y", bench_sprite_set_y},
+    {"sprite_set_w", bench_sprite_set_w},
+    {"sprite_set_h", bench_sprite_set_h},
+    {"sprite_set_th", bench_sprite_set_th},
+    {"sprite_intersect", bench_sprite_intersect},
+    {"scroll_pipes", bench_scroll_pipes},
+    {"recycle_pipes", bench_recycle_pipes},
+    {"xoroshiro128plus", bench_xoroshiro128plus},
+    {"world_step", bench_world_step},
+    {"run_ahead", bench_run_ahead},
+};
+
+static void reset_data(BenchData *bench) {
+  world_seed(&bench->world, 0);
+  scene_build(&bench->world, bench->sprites);
+  bench->random_state[0] = bench->world.random_state[0];
+  bench->random_state[1] = bench->world.random_state[1];
+}
+
+/**
+ * Run the microbenchmarks and print the results as JSON.
+ * With --compare, print how they compare to a saved baseline instead
+ * and exit with 1 if anything regressed.
+ *
+ * Timings only compare on the machine that took them: save a baseline
+ * with --save before a change and compare against it after, on the same
+ * machine. bench/baseline.json was saved on one developer machine and
+ * only shows the format and rough magnitudes.
+ */
+int main(int argc, char **argv) {
+  MicrobenchConfig config = kDefaultConfig;
+  const char *filter = NULL;
+  const char *save_path = NULL;
+  const char *compare_path = NULL;
+  double threshold = kDefaultThreshold;
+  int rounds = kDefaultRounds;
+
+  for (int i = 1; i < argc; i++) {
+    const char *value = NULL;
+    if ((value = options_get_value(argv[i], "--rounds")) != NULL) {
+      rounds = atoi(value);
+    } else if ((value = options_get_value(argv[i], "--samples")) != NULL) {
+      config.samples = atoi(value);
+    } else if ((value = options_get_value(argv[i], "--sample-time")) != NULL) {
+      config.sample_time = atof(value);
+    } else if ((value = options_get_value(argv[i], "--filter")) != NULL) {
+      filter = value;
+    } else if ((value = options_get_value(argv[i], "--save")) != NULL) {
+      save_path = value;
+    } else if ((value = options_get_value(argv[i], "--compare")) != NULL) {
+      compare_path = value;
+    } else if ((value = options_get_value(argv[i], "--threshold")) != NULL) {
+      threshold = atof(value);
+    } else {
+      fprintf(stderr,
+              "Usage: %s [--rounds=N] [--samples=N] [--sample-time=SECONDS] "
+              "[--filter=TEXT] [--save=FILE] [--compare=FILE] "
+              "[--threshold=FRACTION]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+
+  if (rounds < 1) {
+    rounds = 1;
+  } else if (rounds > kMaxRounds) {
+    rounds = kMaxRounds;
+  }
+
+  const Benchmark *selected[kMaxBenchmarks];
+  int count = 0;
+  for (size_t i = 0; i < sizeof(kBenchmarks) / sizeof(kBenchmarks[0]); i++) {
+    if (filter == NULL || strstr(kBenchmarks[i].name, filter) != NULL) {
+      selected[count++] = &kBenchmarks[i];
+    }
+  }
+
+  static MicrobenchResult runs[kMaxBenchmarks][kMaxRounds];
+  for (int round = 0; round < rounds; round++) {
+    for (int i = 0; i < count; i++) {
+      BenchData bench;
+      reset_data(&bench);
+      microbench_run(selected[i]->name, selected[i]->func, &bench, &config,
+                     &runs[i][round]);
+    }
+  }
+
+  MicrobenchResult results[kMaxBenchmarks];
+  for (int i = 0; i < count; i++) {
+    microbench_merge(runs[i], rounds, &results[i]);
+  }
+
+  if (save_path != NULL) {
+#ifdef _WIN32
+    FILE *file = NULL;
+    fopen_s(&file, save_path, "w");
+#else
+    FILE *file = fopen(save_path, "we");
+#endif
+    if (file == NULL) {
+      fprintf(stderr, "Could not write %s\n", save_path);
+      return 2;
+    }
+    microbench_write_json(file, results, count);
+    fclose(file);
+  }
+
+  if (compare_path == NULL) {
+    microbench_write_json(stdout, results, count);
+    return 0;
+  }
+
+  MicrobenchResult baseline[kMaxBenchmarks];
+  const int baseline_count =
+      microbench_read_json(compare_path, baseline, kMaxBenchmarks);
+  if (baseline_count < 0) {
+    fprintf(stderr, "Could not read %s\n", compare_path);
+    return 2;
+  }
+
+  const int regressions =
+      microbench_compare(baseline, baseline_count, results, count, threshold);
+  if (regressions > 0) {
+    printf("%d regression(s) beyond %.0f%% and noise\n", regressions,
+           threshold * 100.);
+    return 1;
+  }
+  return 0;
+}
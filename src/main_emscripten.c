@@ -3,32 +3,40 @@
 #include <emscripten/emscripten.h>
 #include <glad/glad.h>
 
-#include "sprite.h"
+#include "sprite_gl.h"
 #include "window_gl.h"
 
+#include "assets.h"
 #include "game.h"
+#include "snapshot.h"
+#include "options.h"
 
 static void main_loop(void) {
   if (!window_should_close()) {
-    glClear(GL_COLOR_BUFFER_BIT);
+    window_update();
 
     game_update();
 
-    sprite_update();
+    snapshot_acquire();
 
-    window_update();
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    sprite_gl_update();
   } else {
-    sprite_quit();
+    sprite_gl_quit();
 
     window_quit();
     exit(EXIT_SUCCESS);
   }
 }
 
-int main(void) {
-  emscripten_set_main_loop(main_loop, 60, 0);
+int main(int argc, char **argv) {
+  options_init(argc, argv);
+
+  // The browser paces frames, only the frame rate cap applies.
+  emscripten_set_main_loop(main_loop, (int)options_get()->max_fps, 0);
 
-  window_init();
+  window_gl_init();
 
   // WebGL 1 does not support debug output
   if (glad_glDebugMessageCallback) {
@@ -36,7 +44,12 @@ int main(void) {
     glDebugMessageCallback(window_gl_debug_message_callback, NULL);
   }
 
-  sprite_init();
+  Arena arena;
+  arena_init(&arena, FLAP_ASSETS_ARENA_SIZE);
+
+  sprite_gl_init(&arena);
+
+  arena_destroy(&arena);
 
   glDisable(GL_DEPTH_TEST);
 
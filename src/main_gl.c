@@ -2,15 +2,106 @@
 
 #include <glad/glad.h>
 
+#include "capture_gl.h"
 #include "sprite_gl.h"
 #include "window_gl.h"
 
+#include "assets.h"
+#include "bench.h"
+#include "frame_loop.h"
 #include "game.h"
+#include "renderer.h"
 
-int main(void) {
-  window_init();
+// Benchmark GPU timer queries, used in turn so that the result read back
+// is a frame old and already available.
+static GLuint timer_queries[2] = {0};
+static unsigned int timer_frame = 0;
 
-  sprite_init();
+/**
+ * Create timer queries if benchmarking and the context supports them.
+ * OpenGL ES has no timer queries without extensions.
+ */
+static void create_timer_queries(void) {
+  if (bench_is_running() && glad_glGetQueryObjectui64v) {
+    glGenQueries(2, timer_queries);
+  }
+}
+
+static void begin_timer_query(void) {
+  if (timer_queries[0] != 0) {
+    glBeginQuery(GL_TIME_ELAPSED, timer_queries[timer_frame % 2]);
+  }
+}
+
+static void end_timer_query(void) {
+  if (timer_queries[0] == 0) {
+    return;
+  }
+
+  glEndQuery(GL_TIME_ELAPSED);
+  timer_frame++;
+
+  if (timer_frame > 1) {
+    GLuint64 elapsed = 0;
+    glGetQueryObjectui64v(timer_queries[timer_frame % 2], GL_QUERY_RESULT,
+                          &elapsed);
+    bench_frame_gpu_time((double)elapsed * 1e-9);
+  }
+}
+
+static void draw(void) {
+  begin_timer_query();
+
+  glClear(GL_COLOR_BUFFER_BIT);
+
+  sprite_gl_update();
+
+  end_timer_query();
+
+  capture_gl_frame();
+}
+
+static void draw_probe(void) {
+  glClear(GL_COLOR_BUFFER_BIT);
+
+  sprite_gl_update();
+}
+
+static void finish_probe(void) { glFinish(); }
+
+/**
+ * Time the probe scene in the hidden window, see `bench_probe`.
+ */
+static double time_probe_frames(void) {
+  Arena arena;
+  arena_init(&arena, FLAP_ASSETS_ARENA_SIZE);
+
+  sprite_gl_init(&arena);
+
+  glDisable(GL_DEPTH_TEST);
+  glClearColor(0.53f, 0.81f, 0.92f, 1.f);
+
+  const double frame_time =
+      bench_probe(draw_probe, window_gl_swap_buffers, finish_probe);
+
+  sprite_gl_quit();
+
+  arena_destroy(&arena);
+  return frame_time;
+}
+
+static double probe(void) { return window_gl_probe(time_probe_frames); }
+
+static int run(void) {
+  window_gl_init();
+
+  Arena arena;
+  arena_init(&arena, FLAP_ASSETS_ARENA_SIZE);
+
+  sprite_gl_init(&arena);
+
+  // Files and decode buffers are done with once uploaded.
+  arena_reset(&arena);
 
   glDisable(GL_DEPTH_TEST);
 
@@ -18,18 +109,26 @@ int main(void) {
 
   glClearColor(0.53f, 0.81f, 0.92f, 1.f);
 
-  while (!window_should_close()) {
-    glClear(GL_COLOR_BUFFER_BIT);
+  create_timer_queries();
 
-    game_update();
+  capture_gl_init();
 
-    sprite_update();
+  static const FrameLoop loop = {.draw = draw,
+                                 .present = window_gl_swap_buffers};
+  frame_loop_run(&loop);
 
-    window_update();
+  if (timer_queries[0] != 0) {
+    glDeleteQueries(2, timer_queries);
   }
 
-  sprite_quit();
+  capture_gl_quit();
+
+  sprite_gl_quit();
+
+  arena_destroy(&arena);
 
   window_quit();
   return EXIT_SUCCESS;
 }
+
+const Renderer renderer_gl = {"opengl", probe, run};
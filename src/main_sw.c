@@ -0,0 +1,66 @@
+#include <stdlib.h>
+
+#include "sprite_sw.h"
+#include "window_sw.h"
+
+#include "assets.h"
+#include "bench.h"
+#include "frame_loop.h"
+#include "game.h"
+#include "renderer.h"
+
+// Frames are drawn on the CPU: nothing to wait for.
+static void finish_probe(void) {}
+
+/**
+ * Time the probe scene in the hidden window, see `bench_probe`.
+ */
+static double time_probe_frames(void) {
+  Arena arena;
+  arena_init(&arena, FLAP_ASSETS_ARENA_SIZE);
+
+  sprite_sw_init(&arena);
+
+  sprite_sw_set_clear_color(0.53f, 0.81f, 0.92f);
+
+  const double frame_time =
+      bench_probe(sprite_sw_update, window_sw_present, finish_probe);
+
+  sprite_sw_quit();
+
+  arena_destroy(&arena);
+  return frame_time;
+}
+
+static double probe(void) { return window_sw_probe(time_probe_frames); }
+
+static int run(void) {
+  window_sw_init();
+
+  Arena arena;
+  arena_init(&arena, FLAP_ASSETS_ARENA_SIZE);
+
+  sprite_sw_init(&arena);
+
+  sprite_sw_open_outputs();
+
+  // The image file and decode buffers are done with once converted.
+  arena_reset(&arena);
+
+  game_init();
+
+  sprite_sw_set_clear_color(0.53f, 0.81f, 0.92f);
+
+  static const FrameLoop loop = {.draw = sprite_sw_update,
+                                 .present = window_sw_present};
+  frame_loop_run(&loop);
+
+  sprite_sw_quit();
+
+  arena_destroy(&arena);
+
+  window_quit();
+  return EXIT_SUCCESS;
+}
+
+const Renderer renderer_sw = {"software", probe, run};
@@ -6,28 +6,125 @@
 #include <string.h>
 
 #include "assets_vk.h"
+#include "alloc.h"
+#include "batch.h"
+#include "bench.h"
+#include "capture_vk.h"
+#include "frame_loop.h"
 #include "game.h"
+#include "options.h"
+#include "renderer.h"
 #include "sprite_vk.h"
 #include "window_vk.h"
 
 // Clear blue sky
 static const VkClearValue kFlapClearColor = {{{0.53F, 0.81F, 0.92F, 1.F}}};
 
+// Pipeline cache files are named after this and the device.
+static const char *kPipelineCacheName = "pipeline_cache";
+
+// Seconds between two pipeline cache saves.
+static const float kPipelineCacheSaveInterval = 30.F;
+
+// Swapchain images beyond this are not timed by benchmarks.
+#define kMaxTimedImages 8
+
 static VkInstance instance = VK_NULL_HANDLE;
+static VkSurfaceKHR surface = VK_NULL_HANDLE;
 static SulfurDevice device = {0};
 static SulfurSwapchain swapchain = {0};
 
+// Scratch memory for loading assets and saving the pipeline cache.
+static Arena arena = {0};
+
 static VkPipelineCache pipeline_cache = VK_NULL_HANDLE;
-static VkPipeline pipelines[2] = {0};
+static float last_cache_save = 0.F;
+static VkPipeline pipelines[2] = {0}; // Sprites, ghosts
 
 static VkDescriptorPool descriptor_pool = VK_NULL_HANDLE;
 
-static VkDescriptorSet descriptor_sets[4] = {0};
+static VkDescriptorSet descriptor_set = VK_NULL_HANDLE;
 
 static VkDebugUtilsMessengerEXT debug_messenger = VK_NULL_HANDLE;
 
 static VkDebugReportCallbackEXT debug_report_callback = VK_NULL_HANDLE;
 
+#ifndef NDEBUG
+static VkBool32 debug_utils_available = VK_FALSE;
+#endif
+
+// Benchmark GPU timing: a pair of timestamps per swapchain image.
+static VkQueryPool timestamp_pool = VK_NULL_HANDLE;
+static float timestamp_period = 0.F; // Nanoseconds per tick
+static uint64_t last_timestamps[kMaxTimedImages] = {0};
+static uint32_t timed_frames = 0;
+
+/**
+ * Pick `present_mode` if the surface supports it.
+ * FIFO is always available; MAILBOX falls back to IMMEDIATE
+ * and FIFO_RELAXED to FIFO.
+ */
+static VkPresentModeKHR choose_present_mode(VkSurfaceKHR surface,
+                                            PresentMode present_mode) {
+  VkPresentModeKHR supported[8] = {0};
+  uint32_t supported_count = 8;
+  vkGetPhysicalDeviceSurfacePresentModesKHR(device.physical_device, surface,
+                                            &supported_count, supported);
+
+  VkPresentModeKHR wanted[2] = {VK_PRESENT_MODE_FIFO_KHR,
+                                VK_PRESENT_MODE_FIFO_KHR};
+  switch (present_mode) {
+  case PRESENT_MODE_FIFO_RELAXED:
+    wanted[0] = VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+    break;
+  case PRESENT_MODE_MAILBOX:
+    wanted[0] = VK_PRESENT_MODE_MAILBOX_KHR;
+    wanted[1] = VK_PRESENT_MODE_IMMEDIATE_KHR;
+    break;
+  case PRESENT_MODE_IMMEDIATE:
+    wanted[0] = VK_PRESENT_MODE_IMMEDIATE_KHR;
+    wanted[1] = VK_PRESENT_MODE_MAILBOX_KHR;
+    break;
+  default:
+    break;
+  }
+
+  for (uint32_t i = 0; i < 2; i++) {
+    for (uint32_t j = 0; j < supported_count; j++) {
+      if (supported[j] == wanted[i]) {
+        return wanted[i];
+      }
+    }
+  }
+  return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+/**
+ * Fill in the presentation policy before sulfur creates the swapchain.
+ * Frames in flight map onto the number of swapchain images.
+ */
+static void configure_swapchain(VkSurfaceKHR surface,
+                                PresentMode present_mode) {
+  swapchain.info.presentMode = choose_present_mode(surface, present_mode);
+
+  const int frames_in_flight = options_get()->frames_in_flight;
+  if (frames_in_flight > 0) {
+    VkSurfaceCapabilitiesKHR capabilities = {0};
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device.physical_device, surface,
+                                              &capabilities);
+
+    uint32_t image_count = (uint32_t)frames_in_flight;
+    if (image_count < capabilities.minImageCount) {
+      image_count = capabilities.minImageCount;
+    }
+    if (capabilities.maxImageCount > 0 &&
+        image_count > capabilities.maxImageCount) {
+      image_count = capabilities.maxImageCount;
+    }
+    swapchain.info.minImageCount = image_count;
+  }
+}
+
 static void create_pipelines() {
   VkGraphicsPipelineCreateInfo pipeline_infos[2] = {0};
   for (uint32_t i = 0; i < 2; i++) {
@@ -35,21 +132,34 @@ static void create_pipelines() {
   }
 
   sprite_get_pipeline_create_info(&pipeline_infos[0]);
+  const uint32_t pipeline_count =
+      1 + (uint32_t)sprite_get_ghost_pipeline_create_info(&pipeline_infos[1]);
 
-  vkCreateGraphicsPipelines(device.device, pipeline_cache, 1, pipeline_infos,
-                            NULL, pipelines);
+  vkCreateGraphicsPipelines(device.device, pipeline_cache, pipeline_count,
+                            pipeline_infos, NULL, pipelines);
+
+  capture_vk_create_pipelines(&device, pipeline_count, pipeline_infos,
+                              pipeline_cache);
+
+  // Persist freshly compiled pipelines right away in case we crash later.
+  assets_vk_save_pipeline_cache(&device, &arena, pipeline_cache,
+                                kPipelineCacheName);
 }
 
-static void create_descriptor_sets() {
+/**
+ * Allocate the texture descriptor set.
+ * It does not depend on the swapchain and is shared by all command buffers.
+ */
+static void create_descriptor_set() {
   VkDescriptorPoolSize pool_size = {0};
   pool_size.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-  pool_size.descriptorCount = swapchain.image_count;
+  pool_size.descriptorCount = 1;
 
   VkDescriptorPoolCreateInfo pool_info = {0};
   pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
   pool_info.poolSizeCount = 1;
   pool_info.pPoolSizes = &pool_size;
-  pool_info.maxSets = swapchain.image_count;
+  pool_info.maxSets = 1;
 
   VkResult result =
       vkCreateDescriptorPool(device.device, &pool_info, NULL, &descriptor_pool);
@@ -57,25 +167,73 @@ static void create_descriptor_sets() {
     window_fail_with_error("vkCreateDescriptorPool");
   }
 
-  VkDescriptorSetLayout layouts[4] = {0};
-  for (uint32_t i = 0; i < swapchain.image_count; ++i) {
-    layouts[i] = sprite_get_descriptor_set_layout();
-  }
+  const VkDescriptorSetLayout layout = sprite_get_descriptor_set_layout();
 
   VkDescriptorSetAllocateInfo alloc_info = {0};
   alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
   alloc_info.descriptorPool = descriptor_pool;
-  alloc_info.descriptorSetCount = swapchain.image_count;
-  alloc_info.pSetLayouts = layouts;
+  alloc_info.descriptorSetCount = 1;
+  alloc_info.pSetLayouts = &layout;
 
   result =
-      vkAllocateDescriptorSets(device.device, &alloc_info, descriptor_sets);
+      vkAllocateDescriptorSets(device.device, &alloc_info, &descriptor_set);
   if (result != VK_SUCCESS) {
     window_fail_with_error("vkAllocateDescriptorSets");
   }
 
-  for (uint32_t i = 0; i < swapchain.image_count; ++i) {
-    sprite_create_descriptor(&device, descriptor_sets[i]);
+  sprite_create_descriptor(&device, descriptor_set);
+}
+
+/**
+ * Create the timestamp queries if benchmarking and the device supports
+ * them on every graphics queue.
+ */
+static void create_timestamp_pool() {
+  if (!bench_is_running()) {
+    return;
+  }
+
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(device.physical_device, &properties);
+  if (!properties.limits.timestampComputeAndGraphics) {
+    return;
+  }
+  timestamp_period = properties.limits.timestampPeriod;
+
+  VkQueryPoolCreateInfo pool_info = {0};
+  pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+  pool_info.queryCount = 2 * kMaxTimedImages;
+
+  if (vkCreateQueryPool(device.device, &pool_info, NULL, &timestamp_pool) !=
+      VK_SUCCESS) {
+    timestamp_pool = VK_NULL_HANDLE;
+  }
+}
+
+/**
+ * Hand new GPU frame times over to the benchmark.
+ * Which image was just drawn is not known here, so every image is read
+ * and a result counts when its start timestamp changed.
+ */
+static void read_timestamps() {
+  // Queries are only valid once every command buffer ran.
+  if (timestamp_pool == VK_NULL_HANDLE ||
+      ++timed_frames <= 2 * swapchain.image_count) {
+    return;
+  }
+
+  for (uint32_t i = 0; i < swapchain.image_count && i < kMaxTimedImages;
+       i++) {
+    uint64_t timestamps[2] = {0};
+    const VkResult result = vkGetQueryPoolResults(
+        device.device, timestamp_pool, 2 * i, 2, sizeof(timestamps),
+        timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if (result == VK_SUCCESS && timestamps[0] != last_timestamps[i]) {
+      last_timestamps[i] = timestamps[0];
+      bench_frame_gpu_time((double)(timestamps[1] - timestamps[0]) *
+                           timestamp_period * 1e-9);
+    }
   }
 }
 
@@ -91,32 +249,94 @@ static void record_command_buffers() {
   render_pass_info.clearValueCount = 1;
   render_pass_info.pClearValues = &kFlapClearColor;
 
+  const VkExtent2D extent = swapchain.info.imageExtent;
+
+  const VkViewport viewport = {.x = 0.F,
+                               .y = 0.F,
+                               .width = (float)extent.width,
+                               .height = (float)extent.height,
+                               .minDepth = 0.F,
+                               .maxDepth = 1.F};
+
+  const VkRect2D scissor = {.offset = {0, 0}, .extent = extent};
+
   for (uint32_t i = 0; i < swapchain.image_count; i++) {
     VkCommandBuffer cmd_buf = swapchain.command_buffers[i];
 
     vkBeginCommandBuffer(cmd_buf, &begin_info);
 
+    const int timed = timestamp_pool != VK_NULL_HANDLE && i < kMaxTimedImages;
+    if (timed) {
+      vkCmdResetQueryPool(cmd_buf, timestamp_pool, 2 * i, 2);
+      vkCmdWriteTimestamp(cmd_buf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                          timestamp_pool, 2 * i);
+    }
+
     render_pass_info.framebuffer = swapchain.framebuffers[i];
     vkCmdBeginRenderPass(cmd_buf, &render_pass_info,
                          VK_SUBPASS_CONTENTS_INLINE);
 
     vkCmdBindPipeline(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines[0]);
 
+    vkCmdSetViewport(cmd_buf, 0, 1, &viewport);
+    vkCmdSetScissor(cmd_buf, 0, 1, &scissor);
+
     vkCmdBindDescriptorSets(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS,
                             sprite_get_pipeline_layout(), 0, 1,
-                            &descriptor_sets[i], 0, NULL);
+                            &descriptor_set, 0, NULL);
 
-    sprite_record_command_buffer(cmd_buf);
+    sprite_record_command_buffer(cmd_buf, extent, pipelines[1]);
 
     vkCmdEndRenderPass(cmd_buf);
 
+    capture_vk_record(cmd_buf, i, descriptor_set, &kFlapClearColor);
+
+    if (timed) {
+      vkCmdWriteTimestamp(cmd_buf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                          timestamp_pool, 2 * i + 1);
+    }
+
     vkEndCommandBuffer(cmd_buf);
   }
 }
 
-int main(void) {
-  window_init();
+static void draw(void) {
+  batch_update();
+
+  sprite_vk_update();
+}
+
+static void present(void) {
+  if (!sulfur_swapchain_present(&device, surface, &swapchain)) {
+    // The swapchain was recreated along with its framebuffers.
+    // Pipelines use dynamic viewport and scissor state and the descriptor
+    // set only references the texture, so re-recording is enough.
+    vkDeviceWaitIdle(device.device);
+    record_command_buffers();
+    alloc_skip_frame();
+  }
+}
+
+static void frame_presented(void) {
+  read_timestamps();
+
+  capture_vk_read(&device);
+}
 
+static void save_pipeline_cache(void) {
+  if (window_get_time() - last_cache_save > kPipelineCacheSaveInterval) {
+    assets_vk_save_pipeline_cache(&device, &arena, pipeline_cache,
+                                  kPipelineCacheName);
+    arena_reset(&arena);
+    last_cache_save = window_get_time();
+  }
+}
+
+/**
+ * Create the instance and a device and swapchain for the window, asking
+ * for `present_mode`.
+ */
+static void create_device(PresentMode present_mode) {
   static const VkApplicationInfo app_info = {
       .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
       .pApplicationName = "Flap",
@@ -139,7 +359,6 @@ int main(void) {
   memcpy(extensions, window_extensions, extension_count * sizeof(const char *));
 
 #ifndef NDEBUG
-  VkBool32 debug_utils_available = VK_FALSE;
   uint32_t debug_extension_count = 0;
   sulfur_debug_get_extensions(&debug_extension_count,
                               &extensions[extension_count],
@@ -169,59 +388,72 @@ int main(void) {
   }
 #endif
 
-  const VkSurfaceKHR surface = window_vk_create_surface(instance);
+  surface = window_vk_create_surface(instance);
 
   sulfur_device_create(instance, surface, &device);
 
-  sulfur_swapchain_create(&device, surface, &swapchain);
+  configure_swapchain(surface, present_mode);
 
-  assets_vk_create_pipeline_cache(&device, "pipeline_cache.bin",
-                                  &pipeline_cache);
-
-  sprite_init(&device);
+  sulfur_swapchain_create(&device, surface, &swapchain);
+}
 
-  create_pipelines();
+/**
+ * Load the sprites and record command buffers drawing them.
+ */
+static void create_resources(void) {
+  arena_init(&arena, FLAP_ASSETS_ARENA_SIZE);
 
-  create_descriptor_sets();
+  // Before the sprites so that their buffer fits the whole batch.
+  batch_init();
 
-  record_command_buffers();
+  assets_vk_create_pipeline_cache(&device, &arena, kPipelineCacheName,
+                                  &pipeline_cache);
 
-  game_init();
+  sprite_vk_init(&device, &arena);
 
-  while (!window_should_close()) {
-    game_update();
+  create_pipelines();
 
-    window_update();
+  // Files and decode buffers are done with once uploaded.
+  arena_reset(&arena);
 
-    sprite_update();
+  create_descriptor_set();
 
-    if (!sulfur_swapchain_present(&device, surface, &swapchain)) {
-      vkDestroyPipeline(device.device, pipelines[0], NULL);
-      vkDestroyPipeline(device.device, pipelines[1], NULL);
+  create_timestamp_pool();
 
-      create_pipelines();
-      create_descriptor_sets();
-      record_command_buffers();
-    }
-  }
+  record_command_buffers();
+}
 
+/**
+ * Destroy everything from `create_device` and `create_resources`.
+ */
+static void destroy(void) {
   vkDeviceWaitIdle(device.device);
 
   vkDestroyDescriptorPool(device.device, descriptor_pool, NULL);
 
+  if (timestamp_pool != VK_NULL_HANDLE) {
+    vkDestroyQueryPool(device.device, timestamp_pool, NULL);
+    timestamp_pool = VK_NULL_HANDLE;
+  }
+
   vkDestroyPipeline(device.device, pipelines[0], NULL);
   vkDestroyPipeline(device.device, pipelines[1], NULL);
+  pipelines[0] = VK_NULL_HANDLE;
+  pipelines[1] = VK_NULL_HANDLE;
 
-  sprite_quit(&device);
+  sprite_vk_quit(&device);
 
-  assets_vk_destroy_pipeline_cache(&device, pipeline_cache,
-                                   "pipeline_cache.bin");
+  batch_quit();
+
+  assets_vk_destroy_pipeline_cache(&device, &arena, pipeline_cache,
+                                   kPipelineCacheName);
+
+  arena_destroy(&arena);
 
   sulfur_swapchain_destroy(&device, &swapchain);
 
   sulfur_device_destroy(&device);
 
-  window_quit();
   vkDestroySurfaceKHR(instance, surface, NULL);
 
 #ifndef NDEBUG
@@ -234,5 +466,64 @@ int main(void) {
 
   vkDestroyInstance(instance, NULL);
 
+  // The renderer probe runs before the game and leaves nothing behind.
+  const SulfurDevice no_device = {0};
+  const SulfurSwapchain no_swapchain = {0};
+  device = no_device;
+  swapchain = no_swapchain;
+}
+
+static void finish_probe(void) { vkDeviceWaitIdle(device.device); }
+
+/**
+ * Time the probe scene in the hidden window, see `bench_probe`.
+ * Presenting does not wait for the display.
+ */
+static double time_probe_frames(void) {
+  create_device(PRESENT_MODE_IMMEDIATE);
+
+  create_resources();
+
+  const double frame_time =
+      bench_probe(sprite_vk_update, present, finish_probe);
+
+  destroy();
+  return frame_time;
+}
+
+static double probe(void) { return window_vk_probe(time_probe_frames); }
+
+static int run(void) {
+  window_vk_init();
+
+  create_device(options_get()->present_mode);
+
+  // Before the pipelines, which are also made for the capture targets.
+  capture_vk_init(&device, &swapchain);
+
+  create_resources();
+
+  game_init();
+
+  last_cache_save = window_get_time();
+
+  static const FrameLoop loop = {.draw = draw,
+                                 .present = present,
+                                 .frame_presented = frame_presented,
+                                 .between_frames = save_pipeline_cache,
+                                 .offline_is_running = batch_is_running,
+                                 .offline_is_done = batch_is_done};
+  frame_loop_run(&loop);
+
+  vkDeviceWaitIdle(device.device);
+
+  capture_vk_quit(&device);
+
+  destroy();
+
+  window_quit();
+
   return 0;
 }
+
+const Renderer renderer_vk = {"vulkan", probe, run};
@@ -0,0 +1,347 @@
+#include "microbench.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "pacing.h"
+
+// Cycles, instructions, branch misses and cache misses.
+#define kMicrobenchCounters 4
+
+// Samples are kept for statistics up to this many.
+#define kMicrobenchMaxSamples 1000
+
+// Scale from median absolute deviation to standard deviation for normal
+// noise.
+static const double kMadToSigma = 1.4826;
+
+// Differences within this many standard deviations are noise.
+static const double kNoiseSigmas = 3.;
+
+/**
+ * Hardware counters, read as one group.
+ */
+typedef struct Counters {
+  int fds[kMicrobenchCounters];
+  int open;
+} Counters;
+
+#ifdef __linux__
+static int open_counter(uint64_t config, int group) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = config;
+  attr.disabled = group == -1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP;
+  return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+#endif
+
+/**
+ * Open the counters if perf_event is there and allowed.
+ */
+static void counters_open(Counters *counters) {
+  counters->open = 0;
+
+#ifdef __linux__
+  static const uint64_t kConfigs[kMicrobenchCounters] = {
+      PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_CACHE_MISSES};
+
+  for (int i = 0; i < kMicrobenchCounters; i++) {
+    counters->fds[i] = open_counter(kConfigs[i], i > 0 ? counters->fds[0] : -1);
+    if (counters->fds[i] < 0) {
+      for (int j = 0; j < i; j++) {
+        close(counters->fds[j]);
+      }
+      return;
+    }
+  }
+  counters->open = 1;
+#endif
+}
+
+static void counters_start(Counters *counters) {
+#ifdef __linux__
+  if (counters->open) {
+    ioctl(counters->fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(counters->fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+#endif
+}
+
+/**
+ * Stop counting, close the counters and store counts in `values`.
+ * Return 0 if there are no counts.
+ */
+static int counters_stop(Counters *counters, double *values) {
+  if (!counters->open) {
+    return 0;
+  }
+
+  int ok = 0;
+#ifdef __linux__
+  ioctl(counters->fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+  struct {
+    uint64_t count;
+    uint64_t values[kMicrobenchCounters];
+  } data;
+  if (read(counters->fds[0], &data, sizeof(data)) == (ssize_t)sizeof(data) &&
+      data.count == kMicrobenchCounters) {
+    for (int i = 0; i < kMicrobenchCounters; i++) {
+      values[i] = (double)data.values[i];
+    }
+    ok = 1;
+  }
+
+  for (int i = 0; i < kMicrobenchCounters; i++) {
+    close(counters->fds[i]);
+  }
+#endif
+  counters->open = 0;
+  return ok;
+}
+
+static double time_iterations(MicrobenchFunc func, void *data,
+                              uint64_t iterations) {
+  const double start = pacing_get_time();
+  func(data, iterations);
+  return pacing_get_time() - start;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+  const double x = *(const double *)a;
+  const double y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+static double median(double *values, int count) {
+  qsort(values, count, sizeof(double), compare_doubles);
+  return count % 2 ? values[count / 2]
+                   : (values[count / 2 - 1] + values[count / 2]) / 2.;
+}
+
+void microbench_run(const char *name, MicrobenchFunc func, void *data,
+                    const MicrobenchConfig *config, MicrobenchResult *result) {
+  memset(result, 0, sizeof(*result));
+  strncpy(result->name, name, sizeof(result->name) - 1);
+
+  // Grow the iteration count until a sample is long enough.
+  uint64_t iterations = 1;
+  for (;;) {
+    const double time = time_iterations(func, data, iterations);
+    if (time >= config->sample_time) {
+      break;
+    }
+    const double scale = time > 0. ? config->sample_time / time : 10.;
+    iterations = (uint64_t)((double)iterations * (scale < 10. ? scale : 10.)) +
+                 1;
+  }
+
+  const double warmup_end = pacing_get_time() + config->warmup_time;
+  while (pacing_get_time() < warmup_end) {
+    func(data, iterations);
+  }
+
+  int samples = config->samples;
+  if (samples > kMicrobenchMaxSamples) {
+    samples = kMicrobenchMaxSamples;
+  }
+  if (samples < 1) {
+    samples = 1;
+  }
+
+  double times[kMicrobenchMaxSamples];
+  Counters counters;
+  counters_open(&counters);
+  counters_start(&counters);
+
+  for (int i = 0; i < samples; i++) {
+    times[i] = time_iterations(func, data, iterations) * 1e9 / iterations;
+  }
+
+  double counts[kMicrobenchCounters];
+  if (counters_stop(&counters, counts)) {
+    const double operations = (double)iterations * samples;
+    result->has_counters = 1;
+    result->cycles = counts[0] / operations;
+    result->instructions = counts[1] / operations;
+    result->branch_misses = counts[2] / operations;
+    result->cache_misses = counts[3] / operations;
+  }
+
+  result->samples = samples;
+  result->iterations = iterations;
+  result->median_ns = median(times, samples);
+  result->min_ns = times[0];
+
+  for (int i = 0; i < samples; i++) {
+    times[i] = times[i] > result->median_ns ? times[i] - result->median_ns
+                                            : result->median_ns - times[i];
+  }
+  result->mad_ns = median(times, samples);
+}
+
+void microbench_merge(const MicrobenchResult *runs, const int count,
+                      MicrobenchResult *result) {
+  *result = runs[0];
+
+  double medians[kMicrobenchMaxSamples];
+  double deviations[kMicrobenchMaxSamples];
+  int merged = 0;
+  for (int i = 0; i < count && i < kMicrobenchMaxSamples; i++) {
+    medians[merged] = runs[i].median_ns;
+    deviations[merged] = runs[i].mad_ns;
+    merged++;
+
+    if (runs[i].min_ns < result->min_ns) {
+      result->min_ns = runs[i].min_ns;
+    }
+    if (i > 0) {
+      result->samples += runs[i].samples;
+      result->cycles += runs[i].cycles;
+      result->instructions += runs[i].instructions;
+      result->branch_misses += runs[i].branch_misses;
+      result->cache_misses += runs[i].cache_misses;
+      result->has_counters = result->has_counters && runs[i].has_counters;
+    }
+  }
+
+  result->cycles /= merged;
+  result->instructions /= merged;
+  result->branch_misses /= merged;
+  result->cache_misses /= merged;
+
+  const double within = median(deviations, merged);
+  result->median_ns = median(medians, merged);
+
+  for (int i = 0; i < merged; i++) {
+    medians[i] = medians[i] > result->median_ns
+                     ? medians[i] - result->median_ns
+                     : result->median_ns - medians[i];
+  }
+  const double between = median(medians, merged);
+  result->mad_ns = between > within ? between : within;
+}
+
+void microbench_write_json(FILE *file, const MicrobenchResult *results,
+                           const int count) {
+  fprintf(file, "{\n  \"benchmarks\": [\n");
+  for (int i = 0; i < count; i++) {
+    const MicrobenchResult *result = &results[i];
+    fprintf(file,
+            "    {\"name\": \"%s\", \"median_ns\": %.4f, \"mad_ns\": %.4f, "
+            "\"min_ns\": %.4f, \"samples\": %d, \"iterations\": %llu",
+            result->name, result->median_ns, result->mad_ns, result->min_ns,
+            result->samples, (unsigned long long)result->iterations);
+    if (result->has_counters) {
+      fprintf(file,
+              ", \"cycles\": %.3f, \"instructions\": %.3f, "
+              "\"branch_misses\": %.4f, \"cache_misses\": %.4f",
+              result->cycles, result->instructions, result->branch_misses,
+              result->cache_misses);
+    }
+    fprintf(file, "}%s\n", i + 1 < count ? "," : "");
+  }
+  fprintf(file, "  ]\n}\n");
+}
+
+/**
+ * Read the number after `"key": ` in `line`.
+ */
+static int read_number(const char *line, const char *key, double *value) {
+  char pattern[64];
+  snprintf(pattern, sizeof(pattern), "\"%s\": ", key);
+  const char *found = strstr(line, pattern);
+  return found != NULL && sscanf(found + strlen(pattern), "%lf", value) == 1;
+}
+
+int microbench_read_json(const char *path, MicrobenchResult *results,
+                         const int max_count) {
+#ifdef _WIN32
+  FILE *file = NULL;
+  fopen_s(&file, path, "r");
+#else
+  FILE *file = fopen(path, "re");
+#endif
+  if (file == NULL) {
+    return -1;
+  }
+
+  int count = 0;
+  char line[512];
+  while (count < max_count && fgets(line, sizeof(line), file) != NULL) {
+    const char *name = strstr(line, "\"name\": \"");
+    if (name == NULL) {
+      continue;
+    }
+
+    MicrobenchResult *result = &results[count];
+    memset(result, 0, sizeof(*result));
+    if (sscanf(name + 9, "%63[^\"]", result->name) == 1 &&
+        read_number(line, "median_ns", &result->median_ns) &&
+        read_number(line, "mad_ns", &result->mad_ns)) {
+      read_number(line, "min_ns", &result->min_ns);
+      count++;
+    }
+  }
+
+  fclose(file);
+  return count;
+}
+
+int microbench_compare(const MicrobenchResult *baseline,
+                       const int baseline_count,
+                       const MicrobenchResult *results, const int count,
+                       const double threshold) {
+  int regressions = 0;
+
+  printf("%-24s %12s %12s %9s\n", "benchmark", "baseline ns", "current ns",
+         "change");
+
+  for (int i = 0; i < count; i++) {
+    const MicrobenchResult *current = &results[i];
+
+    const MicrobenchResult *base = NULL;
+    for (int j = 0; j < baseline_count; j++) {
+      if (strcmp(baseline[j].name, current->name) == 0) {
+        base = &baseline[j];
+      }
+    }
+    if (base == NULL || base->median_ns <= 0.) {
+      printf("%-24s %12s %12.3f %9s\n", current->name, "-", current->median_ns,
+             "new");
+      continue;
+    }
+
+    const double difference = current->median_ns - base->median_ns;
+    const double change = difference / base->median_ns;
+    const double noise =
+        kNoiseSigmas * kMadToSigma * (current->mad_ns + base->mad_ns);
+
+    const char *verdict = "";
+    if (change > threshold && difference > noise) {
+      verdict = "  REGRESSION";
+      regressions++;
+    } else if (-change > threshold && -difference > noise) {
+      verdict = "  faster";
+    }
+
+    printf("%-24s %12.3f %12.3f %+8.1f%%%s\n", current->name, base->median_ns,
+           current->median_ns, change * 100., verdict);
+  }
+
+  return regressions;
+}
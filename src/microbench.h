@@ -0,0 +1,85 @@
+#ifndef FLAP_MICROBENCH_H
+#define FLAP_MICROBENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * Microbenchmark harness.
+ * A benchmark is a function running `iterations` operations.
+ * It is warmed up, then timed over repeated samples long enough to
+ * dwarf the clock resolution. Times are robust statistics per operation.
+ */
+typedef void (*MicrobenchFunc)(void *data, uint64_t iterations);
+
+typedef struct MicrobenchConfig {
+  int samples;        // Timed repetitions
+  double sample_time; // Seconds per sample, sets the iteration count
+  double warmup_time; // Seconds run before timing
+} MicrobenchConfig;
+
+/**
+ * Results, per operation.
+ * Hardware counters are only there when perf_event is available.
+ */
+typedef struct MicrobenchResult {
+  char name[64];
+  int samples;
+  uint64_t iterations; // Per sample
+  double median_ns;
+  double mad_ns; // Median absolute deviation of the samples
+  double min_ns;
+  int has_counters;
+  double cycles;
+  double instructions;
+  double branch_misses;
+  double cache_misses;
+} MicrobenchResult;
+
+void microbench_run(const char *name, MicrobenchFunc func, void *data,
+                    const MicrobenchConfig *config, MicrobenchResult *result);
+
+/**
+ * Combine runs of the same benchmark made at different times.
+ * The spread between runs counts as noise too: it catches slow drifts,
+ * like clock frequency changes, that samples taken in a row miss.
+ */
+void microbench_merge(const MicrobenchResult *runs, int count,
+                      MicrobenchResult *result);
+
+/**
+ * Keep the compiler from optimizing away work on `pointer`.
+ */
+static inline void microbench_clobber(void *pointer) {
+#if defined(__GNUC__) || defined(__clang__)
+  __asm__ volatile("" : : "g"(pointer) : "memory");
+#else
+  static void *volatile sink;
+  sink = pointer;
+#endif
+}
+
+/**
+ * Write results as JSON, one benchmark per line.
+ */
+void microbench_write_json(FILE *file, const MicrobenchResult *results,
+                           int count);
+
+/**
+ * Read results written by `microbench_write_json`.
+ * Return how many were read, or -1 if the file cannot be opened.
+ */
+int microbench_read_json(const char *path, MicrobenchResult *results,
+                         int max_count);
+
+/**
+ * Print how `results` compare to `baseline`.
+ * A slowdown is a regression when it is above `threshold`, relative,
+ * and beyond the noise of both measurements.
+ * Return the number of regressions.
+ */
+int microbench_compare(const MicrobenchResult *baseline, int baseline_count,
+                       const MicrobenchResult *results, int count,
+                       double threshold);
+
+#endif // FLAP_MICROBENCH_H
@@ -0,0 +1,592 @@
+#include "netplay.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "input.h"
+#include "options.h"
+#include "scene.h"
+#include "window.h"
+#include "world.h"
+#include "xoroshiro.h"
+
+// Steps of saved states and flaps kept.
+#define kNetRing 128
+
+// Steps a peer runs past the last flaps it got from the other one before
+// waiting for more. Bounds how far back a rollback goes.
+#define kMaxRollbackTicks 32
+
+// Flaps sent per packet, enough to cover every step the other peer may
+// be missing: peers are never more than two rollback windows apart.
+#define kMaxPacketTicks 64
+
+#define kMaxPacketSize 32
+
+// Packets held back by `--net-delay`.
+#define kDelayLineSize 256
+
+// Seconds between two requests to join while waiting for an answer.
+static const float kHelloPeriod = 0.25F;
+
+static const uint8_t kMagic[4] = {'F', 'L', 'A', 'P'};
+
+#ifdef _WIN32
+typedef SOCKET Socket;
+#define kInvalidSocket INVALID_SOCKET
+#else
+typedef int Socket;
+#define kInvalidSocket (-1)
+#endif
+
+typedef enum {
+  PACKET_HELLO,  // Joining peer to host, until the race starts
+  PACKET_START,  // Host to joining peer: the course to race on
+  PACKET_INPUTS, // Flaps of a range of steps and the last ones received
+} PacketType;
+
+typedef enum { NET_OFF, NET_WAITING, NET_RACING } NetState;
+
+/**
+ * The whole race, a world per player on the same course.
+ * Plain data: copying a race saves it.
+ */
+typedef struct Race {
+  World players[kNumPlayers];
+  uint64_t seed;
+  uint32_t round;
+} Race;
+
+typedef struct DelayedPacket {
+  float time; // When to send it
+  int size;
+  uint8_t data[kMaxPacketSize];
+} DelayedPacket;
+
+static NetState state = NET_OFF;
+static int local_player = 0;
+
+static Socket sock = kInvalidSocket;
+static struct sockaddr_in peer;
+static int has_peer = 0;
+
+static Race race;
+
+// Race before each step, and flaps of each step, by step modulo the ring.
+static Race saved[kNetRing];
+static uint8_t local_flaps[kNetRing];
+static uint8_t remote_flaps[kNetRing];
+
+static uint32_t tick = 0;             // Next step to simulate
+static uint32_t remote_confirmed = 0; // Steps the other player's flaps are in
+static uint32_t remote_acked = 0;     // Steps the other player has ours for
+static uint32_t rollback_from = UINT32_MAX;
+
+static float start_time = 0.F;
+static float last_hello = 0.F;
+
+// Outgoing packets waiting out `--net-delay`.
+static DelayedPacket delay_line[kDelayLineSize];
+static int delay_head = 0;
+static int delay_count = 0;
+
+static uint64_t random_state[2] = {0};
+
+static struct {
+  uint32_t rollbacks;
+  uint32_t max_depth;
+  uint32_t resimulated;
+  uint32_t stalls;
+  uint32_t sent;
+  uint32_t received;
+  uint32_t dropped;
+} stats = {0};
+
+static void put_u32(uint8_t *data, uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    data[i] = (uint8_t)(value >> (8 * i));
+  }
+}
+
+static void put_u64(uint8_t *data, uint64_t value) {
+  for (int i = 0; i < 8; i++) {
+    data[i] = (uint8_t)(value >> (8 * i));
+  }
+}
+
+static uint32_t get_u32(const uint8_t *data) {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; i++) {
+    value |= (uint32_t)data[i] << (8 * i);
+  }
+  return value;
+}
+
+static uint64_t get_u64(const uint8_t *data) {
+  uint64_t value = 0;
+  for (int i = 0; i < 8; i++) {
+    value |= (uint64_t)data[i] << (8 * i);
+  }
+  return value;
+}
+
+static void race_init(Race *race, uint64_t seed) {
+  race->seed = seed;
+  race->round = 0;
+  for (int i = 0; i < kNumPlayers; i++) {
+    world_seed(&race->players[i], seed);
+  }
+}
+
+/**
+ * Advance the race by one step, bit `i` of `flaps` flapping player `i`.
+ * Once every bird is down, a flap starts a new course for everyone.
+ */
+static void race_step(Race *race, unsigned int flaps) {
+  int over = 1;
+  for (int i = 0; i < kNumPlayers; i++) {
+    over &= race->players[i].state == WORLD_GAMEOVER;
+  }
+
+  if (over) {
+    if (flaps != 0) {
+      race->round++;
+      for (int i = 0; i < kNumPlayers; i++) {
+        world_seed(&race->players[i], race->seed + race->round);
+      }
+    }
+  } else {
+    for (int i = 0; i < kNumPlayers; i++) {
+      if (((flaps >> i) & 1) && race->players[i].state == WORLD_PLAYING) {
+        world_thrust(&race->players[i]);
+      }
+    }
+  }
+
+  for (int i = 0; i < kNumPlayers; i++) {
+    world_step(&race->players[i], kWorldTimeStep);
+  }
+}
+
+/**
+ * Flaps of step `t`, the other player's predicted to be none until known.
+ */
+static unsigned int get_flaps(uint32_t t) {
+  unsigned int flaps = (unsigned int)local_flaps[t % kNetRing] << local_player;
+  if (t < remote_confirmed) {
+    flaps |= (unsigned int)remote_flaps[t % kNetRing] << (1 - local_player);
+  }
+  return flaps;
+}
+
+static float random_float() {
+  return (float)(xoroshiro128plus(random_state) >> 40) / (float)(1 << 24);
+}
+
+static void send_now(const uint8_t *data, int size) {
+  sendto(sock, (const char *)data, size, 0, (const struct sockaddr *)&peer,
+         sizeof(peer));
+}
+
+/**
+ * Send a packet to the other peer, through the simulated network.
+ */
+static void send_packet(const uint8_t *data, int size, float now) {
+  stats.sent++;
+
+  const Options *options = options_get();
+  if (options->net_loss > 0.F && random_float() < options->net_loss) {
+    stats.dropped++;
+    return;
+  }
+
+  if (options->net_delay <= 0.F) {
+    send_now(data, size);
+    return;
+  }
+
+  if (delay_count == kDelayLineSize) {
+    stats.dropped++;
+    return;
+  }
+  DelayedPacket *packet =
+      &delay_line[(delay_head + delay_count) % kDelayLineSize];
+  packet->time = now + options->net_delay;
+  packet->size = size;
+  memcpy(packet->data, data, size);
+  delay_count++;
+}
+
+/**
+ * Send the delayed packets whose time has come.
+ */
+static void flush_delay_line(float now) {
+  while (delay_count > 0 && delay_line[delay_head].time <= now) {
+    send_now(delay_line[delay_head].data, delay_line[delay_head].size);
+    delay_head = (delay_head + 1) % kDelayLineSize;
+    delay_count--;
+  }
+}
+
+static int write_header(uint8_t *data, PacketType type) {
+  memcpy(data, kMagic, sizeof(kMagic));
+  data[4] = (uint8_t)type;
+  return 5;
+}
+
+static void send_hello(float now) {
+  uint8_t data[kMaxPacketSize];
+  const int size = write_header(data, PACKET_HELLO);
+  send_packet(data, size, now);
+}
+
+static void send_start(float now) {
+  uint8_t data[kMaxPacketSize];
+  const int size = write_header(data, PACKET_START);
+  put_u64(&data[size], race.seed);
+  send_packet(data, size + 8, now);
+}
+
+/**
+ * Send every flap the other peer may not have, up to `kMaxPacketTicks`.
+ */
+static void send_inputs(float now) {
+  uint32_t first = remote_acked;
+  if (tick - first > kMaxPacketTicks) {
+    first = tick - kMaxPacketTicks;
+  }
+
+  uint64_t bits = 0;
+  for (uint32_t t = first; t < tick; t++) {
+    bits |= (uint64_t)local_flaps[t % kNetRing] << (t - first);
+  }
+
+  uint8_t data[kMaxPacketSize];
+  const int size = write_header(data, PACKET_INPUTS);
+  put_u32(&data[size], tick);
+  data[size + 4] = (uint8_t)(tick - first);
+  put_u32(&data[size + 5], remote_confirmed);
+  put_u64(&data[size + 9], bits);
+  send_packet(data, size + 17, now);
+}
+
+static void start_race(uint64_t seed, float now) {
+  race_init(&race, seed);
+  state = NET_RACING;
+  start_time = now;
+}
+
+/**
+ * Take in the other player's flaps of steps `end - count` to `end`.
+ * Flaps already simulated as missing mark where to roll back from.
+ */
+static void receive_inputs(const uint8_t *data) {
+  const uint32_t end = get_u32(data);
+  const uint32_t count = data[4];
+  const uint32_t ack = get_u32(&data[5]);
+  const uint64_t bits = get_u64(&data[9]);
+
+  if (ack > remote_acked && ack <= tick) {
+    remote_acked = ack;
+  }
+
+  // Only contiguous flaps, and never more than the ring holds.
+  const uint32_t first = end - count;
+  if (count > kMaxPacketTicks || first > remote_confirmed ||
+      end <= remote_confirmed ||
+      (int32_t)(end - tick) > kNetRing - kMaxRollbackTicks) {
+    return;
+  }
+
+  for (uint32_t t = remote_confirmed; t < end; t++) {
+    const uint8_t flap = (bits >> (t - first)) & 1;
+    remote_flaps[t % kNetRing] = flap;
+    if (flap && t < tick && t < rollback_from) {
+      rollback_from = t;
+    }
+  }
+  remote_confirmed = end;
+}
+
+static void receive_packets(float now) {
+  uint8_t data[kMaxPacketSize];
+  struct sockaddr_in from;
+  socklen_t from_size = sizeof(from);
+
+  int size = 0;
+  while ((size = (int)recvfrom(sock, (char *)data, sizeof(data), 0,
+                               (struct sockaddr *)&from, &from_size)) > 0) {
+    from_size = sizeof(from);
+    if (size < 5 || memcmp(data, kMagic, sizeof(kMagic)) != 0) {
+      continue;
+    }
+
+    // Only one peer at a time: the first to say hello.
+    const int from_peer = has_peer &&
+                          from.sin_addr.s_addr == peer.sin_addr.s_addr &&
+                          from.sin_port == peer.sin_port;
+    if (!from_peer && (has_peer || data[4] != PACKET_HELLO)) {
+      continue;
+    }
+    stats.received++;
+
+    switch (data[4]) {
+    case PACKET_HELLO:
+      if (local_player != 0) {
+        break;
+      }
+      peer = from;
+      has_peer = 1;
+      if (state == NET_WAITING) {
+        start_race(race.seed, now);
+      }
+      // Also answers repeated hellos whose start was lost.
+      send_start(now);
+      break;
+    case PACKET_START:
+      if (state == NET_WAITING && local_player != 0 && size >= 13) {
+        start_race(get_u64(&data[5]), now);
+      }
+      break;
+    case PACKET_INPUTS:
+      if (state == NET_RACING && size >= 22) {
+        receive_inputs(&data[5]);
+      }
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+/**
+ * Whether a local flap happened before `end`, consuming input up to it.
+ */
+static uint8_t read_local_flap(float end) {
+  uint8_t flap = 0;
+  const InputEvent *event = NULL;
+  while ((event = input_peek()) != NULL && event->time < end) {
+    // A race can't be paused.
+    if (event->type == INPUT_THRUST) {
+      flap = 1;
+    }
+    input_pop();
+  }
+  return flap;
+}
+
+/**
+ * Resimulate from the first mispredicted step, then simulate the steps
+ * due by `now` unless too far ahead of the other player.
+ */
+static void advance(float now) {
+  if (rollback_from < tick) {
+    const uint32_t depth = tick - rollback_from;
+    stats.rollbacks++;
+    stats.resimulated += depth;
+    if (depth > stats.max_depth) {
+      stats.max_depth = depth;
+    }
+
+    race = saved[rollback_from % kNetRing];
+    for (uint32_t t = rollback_from; t < tick; t++) {
+      saved[t % kNetRing] = race;
+      race_step(&race, get_flaps(t));
+    }
+  }
+  rollback_from = UINT32_MAX;
+
+  const uint32_t due = (uint32_t)((now - start_time) / kWorldTimeStep);
+  while (tick < due) {
+    if ((int32_t)(tick - remote_confirmed) >= kMaxRollbackTicks) {
+      // Let the other player catch up rather than predict further.
+      stats.stalls++;
+      start_time = now - (float)tick * kWorldTimeStep;
+      break;
+    }
+
+    local_flaps[tick % kNetRing] =
+        read_local_flap(start_time + (float)(tick + 1) * kWorldTimeStep);
+    saved[tick % kNetRing] = race;
+    race_step(&race, get_flaps(tick));
+    tick++;
+  }
+}
+
+/**
+ * Open a non-blocking UDP socket on `port`, any port if 0.
+ */
+static int open_socket(int port) {
+#ifdef _WIN32
+  WSADATA wsa_data;
+  if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) {
+    return 0;
+  }
+#endif
+
+  sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (sock == kInvalidSocket) {
+    return 0;
+  }
+
+  struct sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons((uint16_t)port);
+  if (bind(sock, (const struct sockaddr *)&address, sizeof(address)) != 0) {
+    return 0;
+  }
+
+#ifdef _WIN32
+  u_long non_blocking = 1;
+  return ioctlsocket(sock, FIONBIO, &non_blocking) == 0;
+#else
+  const int flags = fcntl(sock, F_GETFL, 0);
+  return flags >= 0 && fcntl(sock, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+/**
+ * Look up `HOST:PORT` as the peer to send to.
+ */
+static int resolve_peer(const char *host_port) {
+  const char *colon = strrchr(host_port, ':');
+  char host[256];
+  if (colon == NULL || (size_t)(colon - host_port) >= sizeof(host)) {
+    return 0;
+  }
+  memcpy(host, host_port, colon - host_port);
+  host[colon - host_port] = '\0';
+
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+
+  struct addrinfo *result = NULL;
+  if (getaddrinfo(host, colon + 1, &hints, &result) != 0 || result == NULL) {
+    return 0;
+  }
+  memcpy(&peer, result->ai_addr, sizeof(peer));
+  freeaddrinfo(result);
+
+  has_peer = 1;
+  return 1;
+}
+
+void netplay_init() {
+  const Options *options = options_get();
+  if (options->net_host <= 0 && options->net_join == NULL) {
+    return;
+  }
+
+#ifdef __EMSCRIPTEN__
+  window_fail_with_error("Browsers can't race over UDP!");
+  return;
+#endif
+
+  local_player = options->net_host > 0 ? 0 : 1;
+  if (!open_socket(local_player == 0 ? options->net_host : 0)) {
+    window_fail_with_error("Could not open a UDP socket!");
+    return;
+  }
+  if (local_player != 0 && !resolve_peer(options->net_join)) {
+    window_fail_with_error("Could not find the host to join!");
+    return;
+  }
+
+  random_state[0] = (uint64_t)time(NULL);
+  random_state[1] = 0x9e3779b97f4a7c15 ^ (uint64_t)local_player;
+
+  // The host picks the course, the other player gets it when joining.
+  race_init(&race, local_player == 0 ? (uint64_t)time(NULL) : 0);
+
+  state = NET_WAITING;
+  last_hello = window_get_time() - kHelloPeriod;
+}
+
+int netplay_is_running() { return state != NET_OFF; }
+
+void netplay_update(float time) {
+  receive_packets(time);
+
+  if (state == NET_WAITING) {
+    // Nothing to flap at yet.
+    while (input_peek() != NULL) {
+      input_pop();
+    }
+
+    if (local_player != 0 && time - last_hello >= kHelloPeriod) {
+      send_hello(time);
+      last_hello = time;
+    }
+  } else {
+    advance(time);
+    send_inputs(time);
+  }
+
+  flush_delay_line(time);
+}
+
+void netplay_build_scene(Sprite *sprites) {
+  // The course scrolls with whoever flew the longest.
+  const World *leader = &race.players[0];
+  for (int i = 1; i < kNumPlayers; i++) {
+    if (race.players[i].play_time > leader->play_time) {
+      leader = &race.players[i];
+    }
+  }
+  scene_build(leader, sprites);
+
+  // Birds that crashed earlier drift back with the pipes they hit.
+  for (int i = 0; i < kNumPlayers; i++) {
+    const World *player = &race.players[i];
+    scene_build_bird(player, &sprites[i]);
+    sprite_set_x(&sprites[i],
+                 sprite_get_x(&sprites[i]) +
+                     kScrollSpeed * (leader->play_time - player->play_time));
+  }
+}
+
+void netplay_report() {
+  if (state == NET_OFF) {
+    return;
+  }
+
+  printf("Netplay over %u steps, %u rounds:\n", tick, race.round + 1);
+  printf("  rollbacks: %u, deepest %u steps, %u steps resimulated\n",
+         stats.rollbacks, stats.max_depth, stats.resimulated);
+  printf("  stalls:    %u updates waiting for the other player\n",
+         stats.stalls);
+  printf("  packets:   %u sent, %u received, %u dropped\n", stats.sent,
+         stats.received, stats.dropped);
+}
+
+void netplay_quit() {
+  if (sock != kInvalidSocket) {
+#ifdef _WIN32
+    closesocket(sock);
+    WSACleanup();
+#else
+    close(sock);
+#endif
+    sock = kInvalidSocket;
+  }
+  state = NET_OFF;
+}
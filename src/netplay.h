@@ -0,0 +1,43 @@
+#ifndef FLAP_NETPLAY_H
+#define FLAP_NETPLAY_H
+
+#include "sprite.h"
+
+/**
+ * Two player races over UDP.
+ * `--host=PORT` waits for a second player, who connects with
+ * `--join=HOST:PORT`. Both birds fly the same course in lockstep at the
+ * fixed step, each peer sending its flaps to the other every update.
+ * Until the other peer's flaps arrive they are predicted to be none; when
+ * a late one shows up, the race is restored from the state saved before
+ * that step and the steps since are simulated again, within one update.
+ *
+ * `--net-delay=MS` holds back every packet sent and `--net-loss=PERCENT`
+ * drops some, to try the game out over loopback.
+ */
+void netplay_init(void);
+
+/**
+ * Whether a race was asked for.
+ */
+int netplay_is_running(void);
+
+/**
+ * Exchange packets and advance the race to `time`, rolling back first
+ * if the other player's flaps turned out different than predicted.
+ */
+void netplay_update(float time);
+
+/**
+ * Lay out the sprites of the race: every bird over the course.
+ */
+void netplay_build_scene(Sprite *sprites);
+
+/**
+ * Print rollback and packet counts to stdout.
+ */
+void netplay_report(void);
+
+void netplay_quit(void);
+
+#endif // FLAP_NETPLAY_H
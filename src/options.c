@@ -0,0 +1,97 @@
+#include "options.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static Options options = {PRESENT_MODE_FIFO, 0, 0.F, 0, 0, 0, NULL, 0, NULL,
+                          NULL, NULL, 0, NULL, NULL, 0, NULL, 0.F, 0.F, 0};
+
+const char *options_get_value(const char *arg, const char *name) {
+  const size_t len = strlen(name);
+  if (strncmp(arg, name, len) == 0 && arg[len] == '=') {
+    return &arg[len + 1];
+  }
+  return NULL;
+}
+
+static PresentMode parse_present_mode(const char *value) {
+  if (strcmp(value, "fifo-relaxed") == 0) {
+    return PRESENT_MODE_FIFO_RELAXED;
+  } else if (strcmp(value, "mailbox") == 0) {
+    return PRESENT_MODE_MAILBOX;
+  } else if (strcmp(value, "immediate") == 0) {
+    return PRESENT_MODE_IMMEDIATE;
+  }
+  return PRESENT_MODE_FIFO;
+}
+
+void options_init(int argc, char **argv) {
+  int present_mode_set = 0;
+
+  for (int i = 1; i < argc; i++) {
+    const char *value = NULL;
+
+    if ((value = options_get_value(argv[i], "--present-mode")) != NULL) {
+      options.present_mode = parse_present_mode(value);
+      present_mode_set = 1;
+    } else if ((value = options_get_value(argv[i], "--frames-in-flight")) !=
+               NULL) {
+      options.frames_in_flight = atoi(value);
+    } else if ((value = options_get_value(argv[i], "--max-fps")) != NULL) {
+      options.max_fps = (float)atof(value);
+    } else if (strcmp(argv[i], "--just-in-time") == 0) {
+      options.just_in_time = 1;
+    } else if (strcmp(argv[i], "--latency-report") == 0) {
+      options.latency_report = 1;
+    } else if (strcmp(argv[i], "--single-thread") == 0) {
+      options.single_thread = 1;
+    } else if ((value = options_get_value(argv[i], "--headless")) != NULL) {
+      options.headless = value;
+    } else if ((value = options_get_value(argv[i], "--frames")) != NULL) {
+      options.frames = atoi(value);
+    } else if ((value = options_get_value(argv[i], "--renderer")) != NULL) {
+      options.renderer = value;
+    } else if ((value = options_get_value(argv[i], "--bench")) != NULL) {
+      options.bench = value;
+    } else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+      options.bench = argv[++i];
+    } else if ((value = options_get_value(argv[i], "--capture")) != NULL) {
+      options.capture = value;
+    } else if ((value = options_get_value(argv[i], "--batch")) != NULL) {
+      options.batch = atoi(value);
+    } else if ((value = options_get_value(argv[i], "--ghosts")) != NULL) {
+      options.ghosts = value;
+    } else if ((value = options_get_value(argv[i], "--record")) != NULL) {
+      options.record = value;
+    } else if ((value = options_get_value(argv[i], "--host")) != NULL) {
+      options.net_host = atoi(value);
+    } else if ((value = options_get_value(argv[i], "--join")) != NULL) {
+      options.net_join = value;
+    } else if ((value = options_get_value(argv[i], "--net-delay")) != NULL) {
+      options.net_delay = (float)atof(value) / 1000.F;
+    } else if ((value = options_get_value(argv[i], "--net-loss")) != NULL) {
+      options.net_loss = (float)atof(value) / 100.F;
+    } else if ((value = options_get_value(argv[i], "--run-ahead")) != NULL) {
+      options.run_ahead = atoi(value);
+    }
+  }
+
+  // Sampling input late only shows up on screen if the simulation runs
+  // right after it, on the render thread: the simulation thread keeps
+  // its own clock.
+  if (options.just_in_time) {
+    options.single_thread = 1;
+  }
+
+  // Benchmarks measure throughput on a deterministic timeline: no vsync
+  // unless asked for, and no simulation thread racing the virtual clock.
+  // Batch renders are offline too.
+  if (options.bench != NULL || options.batch > 0) {
+    if (!present_mode_set) {
+      options.present_mode = PRESENT_MODE_IMMEDIATE;
+    }
+    options.single_thread = 1;
+  }
+}
+
+const Options *options_get(void) { return &options; }
@@ -0,0 +1,53 @@
+#ifndef FLAP_OPTIONS_H
+#define FLAP_OPTIONS_H
+
+/**
+ * How frames are handed to the display.
+ * Mirrors the Vulkan present modes.
+ */
+typedef enum {
+  PRESENT_MODE_FIFO,         // Vsync, no tearing
+  PRESENT_MODE_FIFO_RELAXED, // Vsync, tear when late
+  PRESENT_MODE_MAILBOX,      // Latest frame wins, no tearing
+  PRESENT_MODE_IMMEDIATE     // No vsync, lowest latency
+} PresentMode;
+
+/**
+ * Runtime options.
+ */
+typedef struct Options {
+  PresentMode present_mode;
+  int frames_in_flight; // 0 lets the backend decide
+  float max_fps;        // 0 means uncapped
+  int just_in_time;     // Sample input as late as possible, single-threaded
+  int latency_report;   // Measure input-to-photon latency
+  int single_thread;    // Simulate on the render thread
+  const char *headless; // Write frames to this file instead of a window
+  int frames;           // Quit after this many frames, 0 means never
+  const char *renderer; // Backend name, NULL picks the first that works
+  const char *bench;    // Benchmark scene to run instead of playing
+  const char *capture;  // Record frames to this video file
+  int batch;            // Replays to draw tiled in each frame, 0 to play
+  const char *ghosts;   // Runs to race against
+  const char *record;   // Append every run played to this file
+  int net_host;         // UDP port to wait for a second player on, 0 if none
+  const char *net_join; // HOST:PORT of the game to join
+  float net_delay;      // Seconds to hold back each packet sent, for testing
+  float net_loss;       // Fraction of packets sent to drop, for testing
+  int run_ahead;        // Steps to draw ahead of the simulation, 0 for none
+} Options;
+
+/**
+ * Parse command line options.
+ * Unknown options are ignored.
+ */
+void options_init(int argc, char **argv);
+
+const Options *options_get(void);
+
+/**
+ * Return the value of `--name=value` or NULL if `arg` is another option.
+ */
+const char *options_get_value(const char *arg, const char *name);
+
+#endif // FLAP_OPTIONS_H
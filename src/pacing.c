@@ -0,0 +1,123 @@
+#include "pacing.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <errno.h>
+#include <time.h>
+#endif
+
+// Leave this much time between the end of the frame and present.
+static const double kPacingSafetyMargin = 0.002;
+
+// Weight of the newest sample in running estimates.
+static const double kPacingSmoothing = 0.05;
+
+// Frame cap
+static double frame_period = 0.;
+static double next_deadline = 0.;
+
+// Just-in-time sampling
+static int jit_enabled = 0;
+static double work_start = 0.;
+static double work_estimate = 0.;
+static double last_present = 0.;
+static double present_period = 0.;
+
+double pacing_get_time(void) {
+#ifdef _WIN32
+  LARGE_INTEGER frequency, counter;
+  QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&counter);
+  return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+#endif
+}
+
+void pacing_sleep_until(double deadline) {
+#ifdef _WIN32
+  const double remaining = deadline - pacing_get_time();
+  if (remaining > 0.) {
+    Sleep((DWORD)(remaining * 1000.));
+  }
+#else
+  struct timespec time;
+  time.tv_sec = (time_t)deadline;
+  time.tv_nsec = (long)((deadline - (double)time.tv_sec) * 1e9);
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &time, NULL) ==
+         EINTR) {
+  }
+#endif
+}
+
+void pacing_init(float max_fps, int just_in_time) {
+  frame_period = max_fps > 0.F ? 1. / max_fps : 0.;
+  next_deadline = pacing_get_time() + frame_period;
+
+  jit_enabled = just_in_time;
+  last_present = 0.;
+  present_period = 0.;
+  work_estimate = 0.;
+}
+
+void pacing_begin_frame(void) {
+  double deadline = 0.;
+
+  if (frame_period > 0.) {
+    deadline = next_deadline;
+  }
+
+  if (jit_enabled && last_present > 0.) {
+    // Start just early enough to be done before the next present.
+    const double period =
+        present_period > frame_period ? present_period : frame_period;
+    const double jit_deadline =
+        last_present + period - work_estimate - kPacingSafetyMargin;
+    if (jit_deadline > deadline) {
+      deadline = jit_deadline;
+    }
+  }
+
+  if (deadline > 0.) {
+    pacing_sleep_until(deadline);
+  }
+
+  work_start = pacing_get_time();
+
+  if (frame_period > 0.) {
+    // Do not try to catch up after a long frame, just start over.
+    next_deadline += frame_period;
+    if (next_deadline < work_start) {
+      next_deadline = work_start + frame_period;
+    }
+  }
+}
+
+void pacing_end_frame(void) {
+  const double cost = pacing_get_time() - work_start;
+
+  // Follow cost spikes at once, decay slowly.
+  if (cost > work_estimate) {
+    work_estimate = cost;
+  } else {
+    work_estimate += (cost - work_estimate) * kPacingSmoothing;
+  }
+}
+
+void pacing_frame_presented(void) {
+  const double now = pacing_get_time();
+
+  if (last_present > 0.) {
+    const double interval = now - last_present;
+    if (present_period == 0.) {
+      present_period = interval;
+    } else {
+      present_period += (interval - present_period) * kPacingSmoothing;
+    }
+  }
+
+  last_present = now;
+}
@@ -0,0 +1,38 @@
+#ifndef FLAP_PACING_H
+#define FLAP_PACING_H
+
+/**
+ * Frame limiter and input sampling scheduler.
+ * Set the target frame rate, 0 disables the limiter.
+ * In just-in-time mode each frame starts as late as the measured
+ * frame cost allows, so input is sampled close to present.
+ */
+void pacing_init(float max_fps, int just_in_time);
+
+/**
+ * Sleep until the current frame should start, before polling input.
+ * Does not busy-wait.
+ */
+void pacing_begin_frame(void);
+
+/**
+ * Mark the end of the frame's CPU work, right before presenting.
+ */
+void pacing_end_frame(void);
+
+/**
+ * Mark the moment presenting returned.
+ */
+void pacing_frame_presented(void);
+
+/**
+ * Monotonic time in seconds.
+ */
+double pacing_get_time(void);
+
+/**
+ * Sleep until `pacing_get_time` reaches `deadline`.
+ */
+void pacing_sleep_until(double deadline);
+
+#endif // FLAP_PACING_H
@@ -0,0 +1,330 @@
+#include "raster.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FLAP_RASTER_SSE2
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define FLAP_RASTER_NEON
+#endif
+
+// Largest frame side supported, for the lookup tables.
+#define kRasterMaxSize 4096
+
+// Fixed point texel coordinates: 16 fractional bits.
+static const int kRasterShift = 16;
+
+/**
+ * Pixels covered by a sprite and the texel under each of them.
+ */
+typedef struct Quad {
+  int x0;
+  int x1;
+  int y0;
+  int y1;
+  int columns[kRasterMaxSize];
+  int rows[kRasterMaxSize];
+} Quad;
+
+/**
+ * Span of pixels whose centers fall in [`from`, `to`), in pixel units.
+ */
+static void get_span(const float from, const float to, const int size,
+                     int *first, int *last) {
+  int a = (int)ceilf(from - 0.5F);
+  int b = (int)ceilf(to - 0.5F);
+  *first = a < 0 ? 0 : a > size ? size : a;
+  *last = b < 0 ? 0 : b > size ? size : b;
+}
+
+/**
+ * Texel index of every pixel in [`first`, `last`), wrapping around.
+ * A quad spans `from` to `to` in pixels and `t0` to `t1` in texels.
+ */
+static void get_texels(const float from, const float to, const float t0,
+                       const float t1, const int first, const int last,
+                       const int size, int *texels) {
+  const double step = (t1 - t0) / (to - from);
+  int64_t t = (int64_t)((t0 + (first + 0.5 - from) * step) *
+                        (1 << kRasterShift));
+  const int64_t dt = (int64_t)(step * (1 << kRasterShift));
+
+  for (int i = first; i < last; i++, t += dt) {
+    int texel = (int)((t >> kRasterShift) % size);
+    texels[i - first] = texel < 0 ? texel + size : texel;
+  }
+}
+
+/**
+ * Find what a sprite covers in a `width` x `height` frame.
+ * Return 0 if nothing.
+ */
+static int setup_quad(const RasterTexture *texture, const Sprite *sprite,
+                      const int width, const int height, Quad *quad) {
+  const SpriteVertex *top_left = &sprite->vertices[0];
+  const SpriteVertex *bottom_right = &sprite->vertices[2];
+
+  // From [-1, 1] to pixels
+  const float left = (top_left->x + 1.F) * 0.5F * width;
+  const float right = (bottom_right->x + 1.F) * 0.5F * width;
+  const float top = (top_left->y + 1.F) * 0.5F * height;
+  const float bottom = (bottom_right->y + 1.F) * 0.5F * height;
+
+  get_span(left, right, width, &quad->x0, &quad->x1);
+  get_span(top, bottom, height, &quad->y0, &quad->y1);
+  if (quad->x0 >= quad->x1 || quad->y0 >= quad->y1) {
+    return 0;
+  }
+
+  get_texels(left, right, top_left->tx * texture->width,
+             bottom_right->tx * texture->width, quad->x0, quad->x1,
+             texture->width, quad->columns);
+  get_texels(top, bottom, top_left->ty * texture->height,
+             bottom_right->ty * texture->height, quad->y0, quad->y1,
+             texture->height, quad->rows);
+  return 1;
+}
+
+/**
+ * Blend one channel of `src` over `dst`, rounding the division by 255.
+ */
+static inline uint32_t blend_channel(const uint32_t src, const uint32_t dst,
+                                     const uint32_t alpha) {
+  const uint32_t t = src * alpha + dst * (255 - alpha) + 128;
+  return (t + (t >> 8)) >> 8;
+}
+
+#ifdef FLAP_RASTER_SSE2
+/**
+ * Blend two pixels widened to 16 bits per channel.
+ */
+static inline __m128i blend_pixels(const __m128i src, const __m128i dst) {
+  const __m128i alpha = _mm_shufflehi_epi16(
+      _mm_shufflelo_epi16(src, _MM_SHUFFLE(3, 3, 3, 3)),
+      _MM_SHUFFLE(3, 3, 3, 3));
+  const __m128i inverse = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+
+  __m128i t = _mm_add_epi16(_mm_mullo_epi16(src, alpha),
+                            _mm_mullo_epi16(dst, inverse));
+  t = _mm_add_epi16(t, _mm_set1_epi16(128));
+  return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+#endif
+
+/**
+ * Blend `count` RGBA8 pixels of `src` over `dst`.
+ */
+static void blend_span(uint32_t *dst, const uint32_t *src, const int count) {
+  int i = 0;
+
+#if defined(FLAP_RASTER_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 4 <= count; i += 4) {
+    const __m128i s = _mm_loadu_si128((const __m128i *)&src[i]);
+    const __m128i d = _mm_loadu_si128((const __m128i *)&dst[i]);
+    const __m128i lo = blend_pixels(_mm_unpacklo_epi8(s, zero),
+                                    _mm_unpacklo_epi8(d, zero));
+    const __m128i hi = blend_pixels(_mm_unpackhi_epi8(s, zero),
+                                    _mm_unpackhi_epi8(d, zero));
+    _mm_storeu_si128((__m128i *)&dst[i], _mm_packus_epi16(lo, hi));
+  }
+#elif defined(FLAP_RASTER_NEON)
+  // Byte 3 of each pixel, twice.
+  const uint8x8_t alpha_index = vcreate_u8(0x0707070703030303ULL);
+  for (; i + 2 <= count; i += 2) {
+    const uint8x8_t s = vld1_u8((const uint8_t *)&src[i]);
+    const uint8x8_t d = vld1_u8((const uint8_t *)&dst[i]);
+    const uint8x8_t alpha = vtbl1_u8(s, alpha_index);
+
+    uint16x8_t t = vmull_u8(s, alpha);
+    t = vmlal_u8(t, d, vmvn_u8(alpha));
+    vst1_u8((uint8_t *)&dst[i], vraddhn_u16(t, vrshrq_n_u16(t, 8)));
+  }
+#endif
+
+  for (; i < count; i++) {
+    const uint8_t *s = (const uint8_t *)&src[i];
+    uint8_t *d = (uint8_t *)&dst[i];
+    const uint32_t alpha = s[3];
+    for (int c = 0; c < 4; c++) {
+      d[c] = (uint8_t)blend_channel(s[c], d[c], alpha);
+    }
+  }
+}
+
+int raster_texture_init(RasterTexture *texture, const uint8_t *rgba,
+                        const int width, const int height) {
+  const size_t count = (size_t)width * height;
+
+  texture->width = width;
+  texture->height = height;
+  texture->opaque = 1;
+  texture->luma = malloc(count);
+  texture->rgba = malloc(count * sizeof(uint32_t));
+  if (texture->luma == NULL || texture->rgba == NULL) {
+    raster_texture_free(texture);
+    return -1;
+  }
+
+  memcpy(texture->rgba, rgba, count * sizeof(uint32_t));
+
+  // BT.601 weights in 8 bit fixed point
+  for (size_t i = 0; i < count; i++) {
+    const uint8_t *texel = &rgba[i * 4];
+    texture->luma[i] =
+        (uint8_t)((77 * texel[0] + 150 * texel[1] + 29 * texel[2]) >> 8);
+    if (texel[3] != 255) {
+      texture->opaque = 0;
+    }
+  }
+  return 0;
+}
+
+void raster_texture_free(RasterTexture *texture) {
+  free(texture->luma);
+  free(texture->rgba);
+  texture->luma = NULL;
+  texture->rgba = NULL;
+}
+
+static uint8_t to_byte(const float value) {
+  return (uint8_t)(value <= 0.F ? 0 : value >= 1.F ? 255 : value * 255.F + .5F);
+}
+
+uint8_t raster_luma(const float r, const float g, const float b) {
+  return to_byte(0.299F * r + 0.587F * g + 0.114F * b);
+}
+
+uint32_t raster_rgba(const float r, const float g, const float b) {
+  const uint8_t bytes[4] = {to_byte(r), to_byte(g), to_byte(b), 255};
+  uint32_t pixel;
+  memcpy(&pixel, bytes, sizeof(pixel));
+  return pixel;
+}
+
+void raster_draw_gray(const RasterTexture *texture, const Sprite *sprites,
+                      const int count, const uint8_t background,
+                      uint8_t *frame, const int width, const int height) {
+  memset(frame, background, (size_t)width * height);
+
+  if (width > kRasterMaxSize || height > kRasterMaxSize) {
+    return;
+  }
+
+  Quad quad;
+  for (int i = 0; i < count; i++) {
+    if (!setup_quad(texture, &sprites[i], width, height, &quad)) {
+      continue;
+    }
+
+    const int span = quad.x1 - quad.x0;
+    for (int y = quad.y0; y < quad.y1; y++) {
+      uint8_t *out = &frame[y * width + quad.x0];
+      const int row = quad.rows[y - quad.y0];
+
+      // Magnified rows repeat the one above.
+      if (y > quad.y0 && row == quad.rows[y - quad.y0 - 1]) {
+        memcpy(out, out - width, span);
+        continue;
+      }
+
+      const uint8_t *in = &texture->luma[row * texture->width];
+      for (int x = 0; x < span; x++) {
+        out[x] = in[quad.columns[x]];
+      }
+    }
+  }
+}
+
+void raster_draw_rgba(const RasterTexture *texture, const Sprite *sprites,
+                      const int count, const uint32_t background,
+                      uint32_t *frame, const int width, const int height) {
+  const size_t size = (size_t)width * height;
+  for (size_t i = 0; i < size; i++) {
+    frame[i] = background;
+  }
+
+  raster_draw_over_rgba(texture, sprites, count, frame, width, height);
+}
+
+void raster_draw_over_rgba(const RasterTexture *texture, const Sprite *sprites,
+                           const int count, uint32_t *frame, const int width,
+                           const int height) {
+  if (width > kRasterMaxSize || height > kRasterMaxSize) {
+    return;
+  }
+
+  Quad quad;
+  uint32_t texels[kRasterMaxSize];
+  for (int i = 0; i < count; i++) {
+    if (!setup_quad(texture, &sprites[i], width, height, &quad)) {
+      continue;
+    }
+
+    const int span = quad.x1 - quad.x0;
+    int texel_row = -1;
+    for (int y = quad.y0; y < quad.y1; y++) {
+      uint32_t *out = &frame[y * width + quad.x0];
+      const int row = quad.rows[y - quad.y0];
+
+      // Magnified rows sample the same texels as the one above.
+      if (row != texel_row) {
+        const uint32_t *in = &texture->rgba[row * texture->width];
+        for (int x = 0; x < span; x++) {
+          texels[x] = in[quad.columns[x]];
+        }
+        texel_row = row;
+      }
+
+      if (texture->opaque) {
+        memcpy(out, texels, span * sizeof(uint32_t));
+      } else {
+        blend_span(out, texels, span);
+      }
+    }
+  }
+}
+
+void raster_draw_ghosts_rgba(const RasterTexture *texture,
+                             const Sprite *sprite, const float *offsets,
+                             const int count, const uint8_t opacity,
+                             uint32_t *frame, const int width,
+                             const int height) {
+  if (width > kRasterMaxSize || height > kRasterMaxSize) {
+    return;
+  }
+
+  Quad quad;
+  uint32_t texels[kRasterMaxSize];
+  for (int i = 0; i < count; i++) {
+    Sprite moved = *sprite;
+    for (int v = 0; v < 4; v++) {
+      moved.vertices[v].y += offsets[i];
+    }
+    if (!setup_quad(texture, &moved, width, height, &quad)) {
+      continue;
+    }
+
+    const int span = quad.x1 - quad.x0;
+    int texel_row = -1;
+    for (int y = quad.y0; y < quad.y1; y++) {
+      const int row = quad.rows[y - quad.y0];
+      if (row != texel_row) {
+        const uint32_t *in = &texture->rgba[row * texture->width];
+        for (int x = 0; x < span; x++) {
+          uint32_t texel = in[quad.columns[x]];
+          uint8_t *bytes = (uint8_t *)&texel;
+          bytes[3] = (uint8_t)blend_channel(bytes[3], 0, opacity);
+          texels[x] = texel;
+        }
+        texel_row = row;
+      }
+
+      blend_span(&frame[y * width + quad.x0], texels, span);
+    }
+  }
+}
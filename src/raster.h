@@ -0,0 +1,71 @@
+#ifndef FLAP_RASTER_H
+#define FLAP_RASTER_H
+
+#include <stdint.h>
+
+#include "sprite.h"
+
+/**
+ * A texture decoded for the CPU rasterizer.
+ */
+typedef struct RasterTexture {
+  int width;
+  int height;
+  int opaque;     // No texel is translucent: skip blending
+  uint8_t *luma;  // One byte per texel
+  uint32_t *rgba; // RGBA8 texels
+} RasterTexture;
+
+/**
+ * Convert `width` x `height` RGBA8 texels, as decoded by stb_image.
+ * Return 0 on success.
+ */
+int raster_texture_init(RasterTexture *texture, const uint8_t *rgba,
+                        int width, int height);
+
+void raster_texture_free(RasterTexture *texture);
+
+/**
+ * Luma of a color with components in [0, 1].
+ */
+uint8_t raster_luma(float r, float g, float b);
+
+/**
+ * Opaque RGBA8 pixel of a color with components in [0, 1].
+ */
+uint32_t raster_rgba(float r, float g, float b);
+
+/**
+ * Draw `count` sprites in order into a `width` x `height` grayscale
+ * `frame`, one byte per pixel, cleared to `background` first.
+ * Sprites are axis-aligned quads in the game's coordinate system,
+ * sampled nearest with the texture repeating, like the GPU renderers.
+ */
+void raster_draw_gray(const RasterTexture *texture, const Sprite *sprites,
+                      int count, uint8_t background, uint8_t *frame,
+                      int width, int height);
+
+/**
+ * Same as `raster_draw_gray` into RGBA8 pixels, top row first,
+ * blending translucent texels over what is already drawn.
+ */
+void raster_draw_rgba(const RasterTexture *texture, const Sprite *sprites,
+                      int count, uint32_t background, uint32_t *frame,
+                      int width, int height);
+
+/**
+ * Same as `raster_draw_rgba` without clearing `frame` first.
+ */
+void raster_draw_over_rgba(const RasterTexture *texture, const Sprite *sprites,
+                           int count, uint32_t *frame, int width, int height);
+
+/**
+ * Blend copies of `sprite` over RGBA8 `frame`, one moved down by each of
+ * the `count` `offsets`, with the opacity of every texel scaled by
+ * `opacity` out of 255.
+ */
+void raster_draw_ghosts_rgba(const RasterTexture *texture, const Sprite *sprite,
+                             const float *offsets, int count, uint8_t opacity,
+                             uint32_t *frame, int width, int height);
+
+#endif // FLAP_RASTER_H
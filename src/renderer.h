@@ -0,0 +1,31 @@
+#ifndef FLAP_RENDERER_H
+#define FLAP_RENDERER_H
+
+/**
+ * A rendering backend.
+ * Every backend built into the binary has one and the game picks one of
+ * them at startup.
+ */
+typedef struct Renderer {
+  const char *name; // As given to --renderer
+
+  /**
+   * Check that the backend works on this machine and time the game's own
+   * drawing of the same scene as every other backend, uploads and
+   * presents included, in a hidden window. See `bench_probe`.
+   * Return seconds per frame, or a negative value if it cannot run.
+   */
+  double (*probe)(void);
+
+  /**
+   * Open the window and play until it is closed.
+   * Return the process exit status.
+   */
+  int (*run)(void);
+} Renderer;
+
+extern const Renderer renderer_vk;
+extern const Renderer renderer_gl;
+extern const Renderer renderer_sw;
+
+#endif // FLAP_RENDERER_H
@@ -0,0 +1,81 @@
+#include "scene.h"
+
+// Bird
+static const float kBirdTextureX = 0.F;
+static const float kBirdTextureY = 0.F;
+static const float kBirdTextureWidth = 32.F;
+static const float kBirdTextureHeight = 32.F;
+
+// Pipes
+static const float kPipeHeadTextureX = 64.F;
+static const float kPipeHeadTextureY = 0.F;
+static const float kPipeHeadTextureWidth = 32.F;
+static const float kPipeHeadTextureHeight = 16.F;
+
+static const float kPipeBodyTextureX = 102.F;
+static const float kPipeBodyTextureY = 0.F;
+static const float kPipeBodyTextureWidth = 20.F;
+static const float kPipeBodyTextureHeight = 32.F;
+
+static void set_box(Sprite *sprite, const Box *box) {
+  sprite_set_x(sprite, box->left);
+  sprite_set_y(sprite, box->top);
+  sprite_set_w(sprite, box->right - box->left);
+  sprite_set_h(sprite, box->bottom - box->top);
+}
+
+void scene_build_bird(const World *world, Sprite *sprite) {
+  const Box bird = world_get_bird_box(world);
+  sprite_set_texture(sprite, kBirdTextureX, kBirdTextureY, kBirdTextureWidth,
+                     kBirdTextureHeight);
+  set_box(sprite, &bird);
+}
+
+void scene_build(const World *world, Sprite *sprites) {
+  scene_build_bird(world, &sprites[0]);
+
+  // Empty quads draw nothing.
+  const Box hidden = {0.F, 0.F, 0.F, 0.F};
+  for (int i = 1; i < kNumPlayers; i++) {
+    set_box(&sprites[i], &hidden);
+  }
+
+  for (int i = 0; i < kNumPipes; i++) {
+    Sprite *pipe = &sprites[kNumPlayers + i * kSpritesPerPipe];
+
+    Box boxes[kSpritesPerPipe];
+    world_get_pipe_boxes(&world->pipes[i], boxes);
+
+    // Top pipe body
+    sprite_set_texture(&pipe[0], kPipeBodyTextureX, kPipeBodyTextureY,
+                       kPipeBodyTextureWidth, kPipeBodyTextureHeight);
+
+    // Top pipe head
+    sprite_set_texture(&pipe[1], kPipeHeadTextureX, kPipeHeadTextureY,
+                       kPipeHeadTextureWidth, kPipeHeadTextureHeight);
+
+    // Bottom pipe head
+    sprite_set_texture(&pipe[2], kPipeHeadTextureX, kPipeHeadTextureY,
+                       kPipeHeadTextureWidth, kPipeHeadTextureHeight);
+
+    // Bottom pipe body
+    sprite_set_texture(&pipe[3], kPipeBodyTextureX, kPipeBodyTextureY,
+                       kPipeBodyTextureWidth, kPipeBodyTextureHeight);
+
+    for (int j = 0; j < kSpritesPerPipe; j++) {
+      set_box(&pipe[j], &boxes[j]);
+    }
+
+    // Repeat the pipe body texture
+    const float th = 2 * world->pipes[i].height / kPipeWidth;
+    sprite_set_th(&pipe[0], th);
+    sprite_set_th(&pipe[3], th);
+  }
+}
+
+void scene_build_ghost(Sprite *sprite) {
+  const Box bird = {kBirdX, 0.F, kBirdX + kBirdWidth, kBirdHeight};
+  sprite_set_texture(sprite, kBirdTextureX, kBirdTextureY, kBirdTextureWidth,
+                     kBirdTextureHeight);
+  set_box(sprite, &bird);
+}
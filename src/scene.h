@@ -0,0 +1,25 @@
+#ifndef FLAP_SCENE_H
+#define FLAP_SCENE_H
+
+#include "sprite.h"
+#include "world.h"
+
+/**
+ * Lay out the sprites that draw `world`: a bird per player, the first one
+ * from `world` and the others hidden, then the four sprites of each pipe,
+ * `kNumSprites` in all.
+ */
+void scene_build(const World *world, Sprite *sprites);
+
+/**
+ * Lay out the bird of `world` alone, for the birds of other players.
+ */
+void scene_build_bird(const World *world, Sprite *sprite);
+
+/**
+ * Lay out the sprite of a ghost bird with its top at 0: ghosts are drawn
+ * from it moved down by their own top, see `ghost.h`.
+ */
+void scene_build_ghost(Sprite *sprite);
+
+#endif // FLAP_SCENE_H
@@ -0,0 +1,101 @@
+#include "simulation.h"
+
+#include <stdatomic.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#elif !defined(__EMSCRIPTEN__)
+#include <pthread.h>
+#endif
+
+#include "alloc.h"
+#include "game.h"
+#include "pacing.h"
+#include "window.h"
+
+// Same rate as the fixed physics step.
+static const double kSimulationPeriod = 1. / 120.;
+
+// Only input can change a frozen world: poll for it less often.
+static const double kIdleSimulationPeriod = 1. / 30.;
+
+static atomic_int running = 0;
+
+#ifdef _WIN32
+static HANDLE thread = NULL;
+#elif !defined(__EMSCRIPTEN__)
+static pthread_t thread;
+#endif
+
+static void run(void) {
+  alloc_set_phase(ALLOC_PHASE_SIMULATE);
+
+  double deadline = pacing_get_time();
+  int was_idle = game_is_idle();
+
+  while (atomic_load_explicit(&running, memory_order_relaxed)) {
+    game_update();
+
+    // The render thread may be blocked waiting for events.
+    const int idle = game_is_idle();
+    if (was_idle && !idle) {
+      window_wake();
+    }
+    was_idle = idle;
+
+    deadline += idle ? kIdleSimulationPeriod : kSimulationPeriod;
+
+    const double now = pacing_get_time();
+    if (deadline < now) {
+      deadline = now;
+    }
+    pacing_sleep_until(deadline);
+  }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI thread_main(LPVOID arg) {
+  (void)arg;
+  run();
+  return 0;
+}
+#elif !defined(__EMSCRIPTEN__)
+static void *thread_main(void *arg) {
+  (void)arg;
+  run();
+  return NULL;
+}
+#endif
+
+int simulation_start(void) {
+  atomic_store(&running, 1);
+
+#ifdef _WIN32
+  thread = CreateThread(NULL, 0, thread_main, NULL, 0, NULL);
+  if (thread != NULL) {
+    return 1;
+  }
+#elif !defined(__EMSCRIPTEN__)
+  if (pthread_create(&thread, NULL, thread_main, NULL) == 0) {
+    return 1;
+  }
+#endif
+
+  atomic_store(&running, 0);
+  return 0;
+}
+
+void simulation_stop(void) {
+  if (!atomic_load(&running)) {
+    return;
+  }
+
+  atomic_store(&running, 0);
+
+#ifdef _WIN32
+  WaitForSingleObject(thread, INFINITE);
+  CloseHandle(thread);
+#elif !defined(__EMSCRIPTEN__)
+  pthread_join(thread, NULL);
+#endif
+}
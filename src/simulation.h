@@ -0,0 +1,18 @@
+#ifndef FLAP_SIMULATION_H
+#define FLAP_SIMULATION_H
+
+/**
+ * Run `game_update` on its own thread at a fixed rate.
+ * Results reach the renderer through snapshots. Input is applied on the
+ * thread's own schedule, not when the render thread polls it, so
+ * `--just-in-time` runs without it.
+ * Return 0 if threads are not available.
+ */
+int simulation_start(void);
+
+/**
+ * Stop and join the simulation thread.
+ */
+void simulation_stop(void);
+
+#endif // FLAP_SIMULATION_H
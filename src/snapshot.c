@@ -0,0 +1,41 @@
+#include "snapshot.h"
+
+#include <stdatomic.h>
+
+static const int kSnapshotIndexMask = 3;
+static const int kSnapshotFresh = 4;
+
+/**
+ * Lock-free triple buffer.
+ * The simulation writes the back buffer, the renderer reads the front
+ * buffer and they swap through the middle one. `middle` also carries
+ * a flag telling whether it holds a snapshot the renderer has not seen.
+ */
+static Snapshot buffers[3];
+static int back = 0;
+static int front = 1;
+static atomic_int middle = 2;
+
+static unsigned int sequence = 0;
+
+Snapshot *snapshot_begin(void) { return &buffers[back]; }
+
+unsigned int snapshot_next_sequence(void) { return sequence + 1; }
+
+void snapshot_publish(void) {
+  buffers[back].sequence = ++sequence;
+
+  back = atomic_exchange_explicit(&middle, back | kSnapshotFresh,
+                                  memory_order_acq_rel) &
+         kSnapshotIndexMask;
+}
+
+const Snapshot *snapshot_acquire(void) {
+  if (atomic_load_explicit(&middle, memory_order_relaxed) & kSnapshotFresh) {
+    front = atomic_exchange_explicit(&middle, front, memory_order_acq_rel) &
+            kSnapshotIndexMask;
+  }
+  return &buffers[front];
+}
+
+const Snapshot *snapshot_get(void) { return &buffers[front]; }
@@ -0,0 +1,47 @@
+#ifndef FLAP_SNAPSHOT_H
+#define FLAP_SNAPSHOT_H
+
+#include "sprite.h"
+
+/**
+ * Everything the renderer needs from one simulation update.
+ */
+typedef struct Snapshot {
+  Sprite sprites[kNumSprites];
+  float ghost_ys[kMaxGhosts]; // Top of each ghost bird, see `ghost.h`
+  int ghost_count;
+  unsigned int sequence; // Increases with every published snapshot
+  int idle;              // See `game_is_idle`
+} Snapshot;
+
+/**
+ * Return the snapshot to fill in.
+ * Must only be called from the simulation thread.
+ */
+Snapshot *snapshot_begin(void);
+
+/**
+ * Return the sequence number the snapshot being filled in will have.
+ * Must only be called from the simulation thread.
+ */
+unsigned int snapshot_next_sequence(void);
+
+/**
+ * Hand the filled snapshot over to the renderer.
+ * Never blocks.
+ */
+void snapshot_publish(void);
+
+/**
+ * Switch to the latest published snapshot if there is a new one
+ * and return it.
+ * Must only be called from the render thread.
+ */
+const Snapshot *snapshot_acquire(void);
+
+/**
+ * Return the snapshot last returned by `snapshot_acquire`.
+ */
+const Snapshot *snapshot_get(void);
+
+#endif // FLAP_SNAPSHOT_H
@@ -0,0 +1,276 @@
+#include "solver.h"
+
+#include <math.h>
+
+#include "xoroshiro.h"
+
+/**
+ * Bird trajectory since `start`, in closed form.
+ * `speed` is the velocity of the parabola through the step boundaries of
+ * the semi-implicit integrator, half a step of gravity ahead of `speed_y`.
+ */
+typedef struct Trajectory {
+  float start;
+  float y;
+  float speed;
+} Trajectory;
+
+static float trajectory_y(const Trajectory *tr, const float t) {
+  const float dt = t - tr->start;
+  return tr->y + tr->speed * dt + 0.5F * kGravity * dt * dt;
+}
+
+static float trajectory_speed(const Trajectory *tr, const float t) {
+  return tr->speed + kGravity * (t - tr->start);
+}
+
+/**
+ * Times in [`a`, `b`] at which the trajectory reaches `y`, ascending.
+ * Return their number.
+ */
+static int trajectory_solve(const Trajectory *tr, const float y, const float a,
+                            const float b, float *roots) {
+  // 0.5 g dt^2 + speed dt + (y0 - y) = 0
+  const float qa = 0.5F * kGravity;
+  const float qb = tr->speed;
+  const float qc = tr->y - y;
+
+  const float disc = qb * qb - 4.F * qa * qc;
+  if (disc < 0.F) {
+    return 0;
+  }
+
+  // Avoid cancellation between qb and the square root.
+  const float q = -0.5F * (qb + copysignf(sqrtf(disc), qb));
+  float r0 = q / qa;
+  float r1 = q != 0.F ? qc / q : r0;
+  if (r0 > r1) {
+    const float r = r0;
+    r0 = r1;
+    r1 = r;
+  }
+
+  int count = 0;
+  r0 += tr->start;
+  r1 += tr->start;
+  if (r0 >= a && r0 <= b) {
+    roots[count++] = r0;
+  }
+  if (r1 >= a && r1 <= b && r1 != r0) {
+    roots[count++] = r1;
+  }
+  return count;
+}
+
+/**
+ * Earliest time in [`a`, `b`] at which the trajectory is strictly between
+ * `lo` and `hi`, or infinity.
+ */
+static float trajectory_enter(const Trajectory *tr, const float lo,
+                              const float hi, const float a, const float b) {
+  if (a > b) {
+    return INFINITY;
+  }
+
+  float times[5];
+  int count = 0;
+  times[count++] = a;
+  count += trajectory_solve(tr, lo, a, b, &times[count]);
+  count += trajectory_solve(tr, hi, a, b, &times[count]);
+
+  // Sort the handful of candidates.
+  for (int i = 1; i < count; i++) {
+    for (int j = i; j > 0 && times[j] < times[j - 1]; j--) {
+      const float t = times[j];
+      times[j] = times[j - 1];
+      times[j - 1] = t;
+    }
+  }
+
+  // Whether the bird is inside just after a candidate tells entries apart.
+  for (int i = 0; i < count; i++) {
+    const float next = i + 1 < count ? times[i + 1] : b;
+    const float y = trajectory_y(tr, next > times[i] ? 0.5F * (times[i] + next)
+                                                     : times[i]);
+    if (y > lo && y < hi) {
+      return times[i];
+    }
+  }
+  return INFINITY;
+}
+
+/**
+ * Lowest and highest point of the trajectory over [`a`, `b`].
+ */
+static void trajectory_range(const Trajectory *tr, const float a,
+                             const float b, float *min, float *max) {
+  const float ya = trajectory_y(tr, a);
+  const float yb = trajectory_y(tr, b);
+  *min = ya < yb ? ya : yb;
+  *max = ya < yb ? yb : ya;
+
+  const float vertex = tr->start - tr->speed / kGravity;
+  if (vertex > a && vertex < b) {
+    const float y = trajectory_y(tr, vertex);
+    *min = y < *min ? y : *min;
+    *max = y > *max ? y : *max;
+  }
+}
+
+/**
+ * Pipes moving at scroll speed, `x` being their position at `since`.
+ */
+typedef struct Track {
+  Pipe pipe;
+  float since;
+} Track;
+
+void solver_run(const World *world, const float *flap_times,
+                const int flap_count, const float horizon,
+                SolverResult *result) {
+  result->hit = SOLVER_CLEAR;
+  result->time = horizon;
+  result->clearance = INFINITY;
+
+  if (world->state != WORLD_PLAYING) {
+    result->hit = SOLVER_OVER;
+    result->time = 0.F;
+    return;
+  }
+
+  uint64_t random_state[2] = {world->random_state[0],
+                              world->random_state[1]};
+  int next_pipe = world->next_pipe;
+
+  Track tracks[kNumPipes];
+  for (int i = 0; i < kNumPipes; i++) {
+    tracks[i].pipe = world->pipes[i];
+    tracks[i].since = 0.F;
+  }
+
+  Trajectory tr = {0.F, world->bird_y,
+                   world->speed_y + 0.5F * kGravity * kWorldTimeStep};
+
+  const float bird_left = world->bird_x;
+  const float bird_right = world->bird_x + kBirdWidth;
+
+  float last_thrust = world->last_thrust - world->time;
+  int flap = 0;
+  float start = 0.F;
+
+  while (start < horizon) {
+    // The next pipe goes back to the far right at the end of the step
+    // in which it crosses the left edge.
+    const Track *track = &tracks[next_pipe];
+    const float cross = track->since + (kScreenLeft - kPipeWidth -
+                                        kPipeBodyX - track->pipe.x) /
+                                           kScrollSpeed;
+    float recycle = ceilf(cross / kWorldTimeStep) * kWorldTimeStep;
+    if (recycle <= start) {
+      recycle = start + kWorldTimeStep;
+    }
+
+    // Late flaps happen right away, unless still cooling down.
+    float next_flap = horizon;
+    for (; flap < flap_count; flap++) {
+      const float t = flap_times[flap] > start ? flap_times[flap] : start;
+      if (t - last_thrust > kThrustDelay) {
+        next_flap = t < horizon ? t : horizon;
+        break;
+      }
+    }
+
+    float end = horizon;
+    end = recycle < end ? recycle : end;
+    end = next_flap < end ? next_flap : end;
+
+    // Screen edges
+    float hit_time = INFINITY;
+    SolverHit hit = SOLVER_CLEAR;
+
+    float t = trajectory_enter(&tr, -INFINITY, kScreenTop, start, end);
+    if (t < hit_time) {
+      hit_time = t;
+      hit = SOLVER_CEILING;
+    }
+    t = trajectory_enter(&tr, kScreenBottom, INFINITY, start, end);
+    if (t < hit_time) {
+      hit_time = t;
+      hit = SOLVER_GROUND;
+    }
+
+    // Pipes, over the time the bird is level with each box.
+    for (int i = 0; i < kNumPipes; i++) {
+      Box boxes[kSpritesPerPipe];
+      world_get_pipe_boxes(&tracks[i].pipe, boxes);
+
+      for (int j = 0; j < kSpritesPerPipe; j++) {
+        const float since = tracks[i].since;
+        const float t_in = since + (bird_right - boxes[j].left) / kScrollSpeed;
+        const float t_out = since + (bird_left - boxes[j].right) / kScrollSpeed;
+
+        const float a = t_in > start ? t_in : start;
+        const float b = t_out < end ? t_out : end;
+        if (a >= b) {
+          continue;
+        }
+
+        const float lo = boxes[j].top - kBirdHeight;
+        const float hi = boxes[j].bottom;
+
+        t = trajectory_enter(&tr, lo, hi, a, b);
+        if (t < hit_time) {
+          hit_time = t;
+          hit = SOLVER_PIPE;
+        }
+
+        float min = 0.F;
+        float max = 0.F;
+        trajectory_range(&tr, a, t < b ? t : b, &min, &max);
+        const float above = lo - max;
+        const float below = min - hi;
+        const float clearance = above > below ? above : below;
+        if (clearance < result->clearance) {
+          result->clearance = clearance > 0.F ? clearance : 0.F;
+        }
+      }
+    }
+
+    if (hit != SOLVER_CLEAR) {
+      result->hit = hit;
+      result->time = hit_time;
+      return;
+    }
+
+    if (end >= horizon) {
+      break;
+    }
+
+    // Carry on from the event at `end`.
+    Trajectory next = {end, trajectory_y(&tr, end), trajectory_speed(&tr, end)};
+    if (end == next_flap && flap < flap_count) {
+      next.speed += kThrust;
+      last_thrust = end;
+      flap++;
+    }
+    tr = next;
+
+    if (end == recycle) {
+      Track *recycled = &tracks[next_pipe];
+      const float play_time = world->play_time + end;
+
+      xoroshiro128plus(random_state);
+      recycled->pipe.x = kScreenRight;
+      recycled->pipe.height =
+          kMinPipeHeight + (float)random_state[0] / UINT64_MAX *
+                               (kMaxPipeHeight - kMinPipeHeight);
+      recycled->pipe.gap =
+          kInitialPipeGap - (play_time / kDeadline) * kInitialPipeGap;
+      recycled->since = end;
+
+      next_pipe = (next_pipe + 1) % kNumPipes;
+    }
+
+    start = end;
+  }
+}
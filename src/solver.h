@@ -0,0 +1,31 @@
+#ifndef FLAP_SOLVER_H
+#define FLAP_SOLVER_H
+
+#include "world.h"
+
+typedef enum {
+  SOLVER_CLEAR,   // Nothing hit before the horizon
+  SOLVER_PIPE,    // The bird hits a pipe
+  SOLVER_CEILING, // The bird flies off the top of the screen
+  SOLVER_GROUND,  // The bird falls off the bottom of the screen
+  SOLVER_OVER     // The world is not playing
+} SolverHit;
+
+typedef struct SolverResult {
+  SolverHit hit;
+  float time;      // Seconds from now until the hit, or the horizon
+  float clearance; // Closest vertical distance to a pipe until `time`
+} SolverResult;
+
+/**
+ * Predict the next collision of a playing world without stepping it.
+ * `flap_times` are sorted times relative to now at which to flap;
+ * flaps during the cooldown are ignored like `world_thrust` does.
+ * The bird follows a parabola between flaps, which matches `world_step`
+ * at fixed step boundaries: pipe hits agree with stepping to within a step,
+ * screen edges, which `world_step` checks once per step, within two.
+ */
+void solver_run(const World *world, const float *flap_times, int flap_count,
+                float horizon, SolverResult *result);
+
+#endif // FLAP_SOLVER_H
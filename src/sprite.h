@@ -1,10 +1,16 @@
 #ifndef FLAP_SPRITE_H
 #define FLAP_SPRITE_H
 
-#define kNumPlayers 1
+#define kNumPlayers 2
+#define kMaxGhosts 4096
+#define kGhostOpacity 0.4F
 #define kSpritesPerPipe 4
 #define kNumPipes 4
-#define kNumSprites kNumPlayers + kSpritesPerPipe * kNumPipes
+#define kNumSprites (kNumPlayers + kSpritesPerPipe * kNumPipes)
+
+// Size of the texture atlas, in texels.
+#define kTextureWidth 128.F
+#define kTextureHeight 32.F
 
 /**
  * A sprite vertex.
@@ -24,15 +30,28 @@ typedef struct Sprite {
 } Sprite;
 
 /**
- * Update vertex data.
+ * Map a portion of the texture, in texels, onto a sprite.
  */
-void sprite_update(void);
+static inline void sprite_set_texture(Sprite *sprite, float texture_x,
+                                      float texture_y, float texture_w,
+                                      float texture_h) {
+  const float left_texcoord = texture_x / kTextureWidth;
+  const float top_texcoord = texture_y / kTextureHeight;
+  const float right_texcoord = (texture_x + texture_w) / kTextureWidth;
+  const float bottom_texcoord = (texture_y + texture_h) / kTextureHeight;
 
-/**
- * Make a new sprite from a portion of the texture.
- */
-Sprite *sprite_new(float texture_x, float texture_y, float texture_w,
-                   float texture_h);
+  sprite->vertices[0].tx = left_texcoord;
+  sprite->vertices[0].ty = top_texcoord;
+
+  sprite->vertices[1].tx = left_texcoord;
+  sprite->vertices[1].ty = bottom_texcoord;
+
+  sprite->vertices[2].tx = right_texcoord;
+  sprite->vertices[2].ty = bottom_texcoord;
+
+  sprite->vertices[3].tx = right_texcoord;
+  sprite->vertices[3].ty = top_texcoord;
+}
 
 static inline void sprite_set_x(Sprite *sprite, float left) {
   const float width = sprite->vertices[2].x - sprite->vertices[0].x;
@@ -3,6 +3,10 @@
 #include <string.h>
 
 #include "assets_gl.h"
+#include "bench.h"
+#include "options.h"
+#include "scene.h"
+#include "snapshot.h"
 #include "window.h"
 
 static GLuint texture = 0;
@@ -14,42 +18,160 @@ static GLuint vao = 0;
 
 static GLuint buffers[2] = {0};
 
-void sprite_init() {
+// Ghosts: the bird quad drawn once per ghost, moved down by an offset
+// read per instance.
+static GLuint ghost_program = 0;
+static GLint ghost_location_texture = 0;
+static GLint ghost_location_opacity = 0;
+static GLuint ghost_attribs[2] = {0}; // Quad vertex, offset
+static GLuint ghost_vao = 0;
+static GLuint ghost_buffers[2] = {0}; // Quad, offsets
+
+static PFNGLDRAWELEMENTSINSTANCEDPROC draw_elements_instanced = NULL;
+static PFNGLVERTEXATTRIBDIVISORPROC vertex_attrib_divisor = NULL;
+
+/**
+ * Point the ghost attributes at their buffers.
+ */
+static void set_ghost_attribs(void) {
+  glBindBuffer(GL_ARRAY_BUFFER, ghost_buffers[0]);
+  glEnableVertexAttribArray(ghost_attribs[0]);
+  glVertexAttribPointer(ghost_attribs[0], 4, GL_FLOAT, GL_FALSE,
+                        4 * sizeof(float), 0);
+
+  glBindBuffer(GL_ARRAY_BUFFER, ghost_buffers[1]);
+  glEnableVertexAttribArray(ghost_attribs[1]);
+  glVertexAttribPointer(ghost_attribs[1], 1, GL_FLOAT, GL_FALSE, sizeof(float),
+                        0);
+  vertex_attrib_divisor(ghost_attribs[1], 1);
+}
+
+static void init_ghosts(Arena *arena, const char *vertex_shader_source,
+                        const char *fragment_shader_source) {
+  if (options_get()->ghosts == NULL) {
+    return;
+  }
+
+  // Core in OpenGL 3.3 and OpenGL ES 3.0, extensions in OpenGL ES 2.0 and
+  // WebGL 1. Without any of them ghosts are raced but not drawn.
+  draw_elements_instanced = glad_glDrawElementsInstanced;
+  vertex_attrib_divisor = glad_glVertexAttribDivisor;
+  if (draw_elements_instanced == NULL || vertex_attrib_divisor == NULL) {
+    draw_elements_instanced = glad_glDrawElementsInstancedEXT;
+    vertex_attrib_divisor = glad_glVertexAttribDivisorEXT;
+  }
+  if (draw_elements_instanced == NULL || vertex_attrib_divisor == NULL) {
+    draw_elements_instanced = glad_glDrawElementsInstancedANGLE;
+    vertex_attrib_divisor = glad_glVertexAttribDivisorANGLE;
+  }
+  if (draw_elements_instanced == NULL || vertex_attrib_divisor == NULL) {
+    return;
+  }
+
+  ghost_program =
+      assets_gl_create_program(arena, "sprite_ghost", vertex_shader_source,
+                               fragment_shader_source);
+  ghost_location_texture =
+      glGetUniformLocation(ghost_program, "texture_sampler");
+  ghost_location_opacity = glGetUniformLocation(ghost_program, "opacity");
+  ghost_attribs[0] = (GLuint)glGetAttribLocation(ghost_program, "in_vertex");
+  ghost_attribs[1] = (GLuint)glGetAttribLocation(ghost_program, "in_offset");
+
+  Sprite ghost = {0};
+  scene_build_ghost(&ghost);
+
+  glGenBuffers(2, ghost_buffers);
+
+  glBindBuffer(GL_ARRAY_BUFFER, ghost_buffers[0]);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(ghost), &ghost, GL_STATIC_DRAW);
+
+  glBindBuffer(GL_ARRAY_BUFFER, ghost_buffers[1]);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(float) * kMaxGhosts, NULL,
+               GL_STREAM_DRAW);
+
+  if (glad_glGenVertexArrays) {
+    glGenVertexArrays(1, &ghost_vao);
+    glBindVertexArray(ghost_vao);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[1]);
+    set_ghost_attribs();
+    glBindVertexArray(vao);
+  }
+
+  glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+  glUseProgram(program);
+}
+
+/**
+ * Draw every ghost of the snapshot, translucent, in one draw call.
+ */
+static void draw_ghosts(const Snapshot *snapshot) {
+  if (ghost_program == 0 || snapshot->ghost_count == 0) {
+    return;
+  }
+
+  glUseProgram(ghost_program);
+
+  glBindBuffer(GL_ARRAY_BUFFER, ghost_buffers[1]);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(float) * kMaxGhosts, NULL,
+               GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(float) * snapshot->ghost_count,
+                  snapshot->ghost_ys);
+
+  if (ghost_vao) {
+    glBindVertexArray(ghost_vao);
+  } else {
+    set_ghost_attribs();
+  }
+
+  glUniform1i(ghost_location_texture, 0);
+  glUniform1f(ghost_location_opacity, kGhostOpacity);
+
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  draw_elements_instanced(GL_TRIANGLES, kIndicesPerSprite, GL_UNSIGNED_SHORT,
+                          0, snapshot->ghost_count);
+  glDisable(GL_BLEND);
+
+  if (ghost_vao) {
+    glBindVertexArray(vao);
+  } else {
+    // Attribute state is global without vertex array objects.
+    vertex_attrib_divisor(ghost_attribs[1], 0);
+    glDisableVertexAttribArray(ghost_attribs[0]);
+    glDisableVertexAttribArray(ghost_attribs[1]);
+  }
+
+  glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+  glUseProgram(program);
+}
+
+void sprite_gl_init(Arena *arena) {
   // Detect which shader to use: OpenGL or OpenGL ES / WebGL
   const GLubyte *version = glGetString(GL_VERSION);
 
   const char *vertex_shader_source = NULL;
   const char *fragment_shader_source = NULL;
+  const char *ghost_vertex_shader_source = NULL;
+  const char *ghost_fragment_shader_source = NULL;
 
 #if defined(__ANDROID__) || defined(__EMSCRIPTEN__)
   vertex_shader_source = "shaders/sprite_es.vert";
   fragment_shader_source = "shaders/sprite_es.frag";
+  ghost_vertex_shader_source = "shaders/sprite_ghost_es.vert";
+  ghost_fragment_shader_source = "shaders/sprite_ghost_es.frag";
 #else
   vertex_shader_source = "shaders/sprite_gl.vert";
   fragment_shader_source = "shaders/sprite_gl.frag";
+  ghost_vertex_shader_source = "shaders/sprite_ghost_gl.vert";
+  ghost_fragment_shader_source = "shaders/sprite_ghost_gl.frag";
 #endif
 
-  GLuint vertex_shader =
-      assets_gl_create_shader(GL_VERTEX_SHADER, vertex_shader_source);
-  GLuint fragment_shader =
-      assets_gl_create_shader(GL_FRAGMENT_SHADER, fragment_shader_source);
-
-  program = glCreateProgram();
-
-  glAttachShader(program, vertex_shader);
-  glAttachShader(program, fragment_shader);
-
-  glLinkProgram(program);
-  assets_gl_check_program(program);
-
-  glDetachShader(program, vertex_shader);
-  glDetachShader(program, fragment_shader);
-  glDeleteShader(vertex_shader);
-  glDeleteShader(fragment_shader);
+  program = assets_gl_create_program(arena, "sprite", vertex_shader_source,
+                                     fragment_shader_source);
 
   glUseProgram(program);
 
-  texture = assets_gl_create_texture("images/atlas.png");
+  texture = assets_gl_create_texture(arena, "images/atlas.png");
   location_texture = glGetUniformLocation(program, "texture_sampler");
 
   if (glad_glGenVertexArrays) {
@@ -68,21 +190,35 @@ void sprite_init() {
 
   glEnableVertexAttribArray(0);
   glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
+
+  init_ghosts(arena, ghost_vertex_shader_source, ghost_fragment_shader_source);
 }
 
-void sprite_quit() {
+void sprite_gl_quit() {
   glDeleteProgram(program);
+  glDeleteProgram(ghost_program);
 
   if (glad_glDeleteVertexArrays) {
     glDeleteVertexArrays(1, &vao);
+    glDeleteVertexArrays(1, &ghost_vao);
   }
 
   glDeleteBuffers(2, buffers);
+  glDeleteBuffers(2, ghost_buffers);
   glDeleteTextures(1, &texture);
+
+  // The renderer probe draws in a context of its own before the game.
+  program = 0;
+  ghost_program = 0;
+  vao = 0;
+  ghost_vao = 0;
 }
 
-void sprite_update() {
-  glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_DYNAMIC_DRAW);
+void sprite_gl_update() {
+  const Snapshot *snapshot = snapshot_get();
+
+  glBufferData(GL_ARRAY_BUFFER, sizeof(snapshot->sprites), snapshot->sprites,
+               GL_DYNAMIC_DRAW);
 
   if (!glad_glGenVertexArrays) {
     glEnableVertexAttribArray(0);
@@ -91,10 +227,15 @@ void sprite_update() {
 
   glUniform1i(location_texture, 0);
 
-  glDrawElements(GL_TRIANGLES, kIndicesPerSprite * kNumSprites,
-                 GL_UNSIGNED_SHORT, 0);
+  const int repeat = bench_get_repeat();
+  for (int i = 0; i < repeat; i++) {
+    glDrawElements(GL_TRIANGLES, kIndicesPerSprite * kNumSprites,
+                   GL_UNSIGNED_SHORT, 0);
+  }
 
   if (!glad_glGenVertexArrays) {
     glDisableVertexAttribArray(0);
   }
+
+  draw_ghosts(snapshot);
 }
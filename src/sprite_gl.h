@@ -1,12 +1,18 @@
 #pragma once
+#include "arena.h"
 #include "sprite.h"
 
 /**
- * Load shaders and resources.
+ * Load shaders and resources, using `arena` for scratch memory.
  */
-void sprite_init(void);
+void sprite_gl_init(Arena *arena);
 
 /**
  * Free shaders and resources.
  */
-void sprite_quit(void);
+void sprite_gl_quit(void);
+
+/**
+ * Upload the latest snapshot and draw it.
+ */
+void sprite_gl_update(void);
@@ -3,14 +3,9 @@
 
 static const int kIndicesPerSprite = 6; // Two triangles
 
-static const float kTextureWidth = 128.F;
-static const float kTextureHeight = 32.F;
-
-static unsigned int count = 0;
-
 static Sprite vertices[kNumSprites];
 
-const unsigned short indices[] = {
+static const unsigned short indices[] = {
     0,   1,   2,   2,   0,   3,   4,   5,   6,   6,   4,   7,   8,   9,   10,
     10,  8,   11,  12,  13,  14,  14,  12,  15,  16,  17,  18,  18,  16,  19,
     20,  21,  22,  22,  20,  23,  24,  25,  26,  26,  24,  27,  28,  29,  30,
@@ -29,27 +24,3 @@ const unsigned short indices[] = {
     150, 148, 151, 152, 153, 154, 154, 152, 155, 156, 157, 158, 158, 156, 159,
     160, 161, 162, 162, 160, 163, 164, 165, 166, 166, 164, 167,
 };
-
-Sprite *sprite_new(float texture_x, float texture_y, float texture_w,
-                   float texture_h) {
-  Sprite *sprite = &vertices[count++];
-
-  const float left_texcoord = texture_x / kTextureWidth;
-  const float top_texcoord = texture_y / kTextureHeight;
-  const float right_texcoord = (texture_x + texture_w) / kTextureWidth;
-  const float bottom_texcoord = (texture_y + texture_h) / kTextureHeight;
-
-  sprite->vertices[0].tx = left_texcoord;
-  sprite->vertices[0].ty = top_texcoord;
-
-  sprite->vertices[1].tx = left_texcoord;
-  sprite->vertices[1].ty = bottom_texcoord;
-
-  sprite->vertices[2].tx = right_texcoord;
-  sprite->vertices[2].ty = bottom_texcoord;
-
-  sprite->vertices[3].tx = right_texcoord;
-  sprite->vertices[3].ty = top_texcoord;
-
-  return sprite;
-}
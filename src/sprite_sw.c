@@ -0,0 +1,149 @@
+#include "sprite_impl.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "alloc.h"
+#include "assets_sw.h"
+#include "bench.h"
+#include "capture.h"
+#include "options.h"
+#include "raster.h"
+#include "scene.h"
+#include "snapshot.h"
+#include "window_sw.h"
+
+static RasterTexture texture = {0};
+
+static uint32_t clear_color = 0;
+
+static uint32_t *framebuffer = NULL;
+static int framebuffer_width = 0;
+static int framebuffer_height = 0;
+
+// Bird every ghost is drawn from.
+static Sprite ghost = {0};
+
+// Headless mode: frames go to a stream of binary PPM images.
+static FILE *output = NULL;
+static unsigned char *output_row = NULL;
+
+static void write_frame(void) {
+  fprintf(output, "P6\n%d %d\n255\n", framebuffer_width, framebuffer_height);
+
+  for (int y = 0; y < framebuffer_height; y++) {
+    const uint8_t *in = (const uint8_t *)&framebuffer[y * framebuffer_width];
+    for (int x = 0; x < framebuffer_width; x++) {
+      output_row[x * 3] = in[x * 4];
+      output_row[x * 3 + 1] = in[x * 4 + 1];
+      output_row[x * 3 + 2] = in[x * 4 + 2];
+    }
+    fwrite(output_row, 3, framebuffer_width, output);
+  }
+}
+
+/**
+ * Match the framebuffer to the window.
+ */
+static void resize(void) {
+  int width = 0;
+  int height = 0;
+  window_sw_get_size(&width, &height);
+  if (width == framebuffer_width && height == framebuffer_height) {
+    return;
+  }
+
+  alloc_skip_frame();
+
+  free(framebuffer);
+  free(output_row);
+  framebuffer = malloc(sizeof(uint32_t) * width * height);
+  output_row = malloc(3 * width);
+  if (framebuffer == NULL || output_row == NULL) {
+    window_fail_with_error("Out of memory for the framebuffer!");
+  }
+
+  framebuffer_width = width;
+  framebuffer_height = height;
+}
+
+void sprite_sw_init(Arena *arena) {
+  assets_sw_create_texture(arena, "images/atlas.png", &texture);
+
+  scene_build_ghost(&ghost);
+}
+
+void sprite_sw_open_outputs() {
+  const char *headless = options_get()->headless;
+  if (headless != NULL) {
+    output = fopen(headless, "wb");
+    if (output == NULL) {
+      window_fail_with_error("Could not open the headless output file!");
+    }
+  }
+
+  int width = 0;
+  int height = 0;
+  window_sw_get_size(&width, &height);
+  capture_init(width, height);
+}
+
+void sprite_sw_quit() {
+  capture_quit();
+
+  if (output != NULL) {
+    fclose(output);
+    output = NULL;
+  }
+
+  raster_texture_free(&texture);
+
+  free(framebuffer);
+  free(output_row);
+  framebuffer = NULL;
+  output_row = NULL;
+  framebuffer_width = 0;
+  framebuffer_height = 0;
+}
+
+void sprite_sw_set_clear_color(float r, float g, float b) {
+  clear_color = raster_rgba(r, g, b);
+}
+
+void sprite_sw_update() {
+  resize();
+
+  const Snapshot *snapshot = snapshot_get();
+
+  raster_draw_rgba(&texture, snapshot->sprites, kNumSprites, clear_color,
+                   framebuffer, framebuffer_width, framebuffer_height);
+
+  // Further passes over the scene, like extra draw calls on the GPU.
+  for (int i = 1; i < bench_get_repeat(); i++) {
+    raster_draw_over_rgba(&texture, snapshot->sprites, kNumSprites,
+                          framebuffer, framebuffer_width, framebuffer_height);
+  }
+
+  raster_draw_ghosts_rgba(&texture, &ghost, snapshot->ghost_ys,
+                          snapshot->ghost_count,
+                          (uint8_t)(kGhostOpacity * 255.F + .5F), framebuffer,
+                          framebuffer_width, framebuffer_height);
+
+  // Frames are already in memory: no read back to wait for.
+  if (capture_is_running()) {
+    int width = 0;
+    int height = 0;
+    capture_get_size(&width, &height);
+    if (width == framebuffer_width && height == framebuffer_height) {
+      capture_write_frame((const uint8_t *)framebuffer, (ptrdiff_t)width * 4);
+    } else {
+      capture_drop_frame();
+    }
+  }
+
+  if (output != NULL) {
+    write_frame();
+  } else {
+    window_sw_draw(framebuffer, framebuffer_width, framebuffer_height);
+  }
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "arena.h"
+#include "sprite.h"
+
+/**
+ * Load the texture, using `arena` for scratch memory.
+ */
+void sprite_sw_init(Arena *arena);
+
+/**
+ * Open the headless output and start the capture, if asked for.
+ */
+void sprite_sw_open_outputs(void);
+
+/**
+ * Free the texture and framebuffer.
+ */
+void sprite_sw_quit(void);
+
+/**
+ * Draw the latest snapshot and hand it to the window.
+ */
+void sprite_sw_update(void);
+
+/**
+ * Set the color frames are cleared to.
+ */
+void sprite_sw_set_clear_color(float r, float g, float b);
@@ -9,6 +9,11 @@
 #include <sulfur/texture.h>
 
 #include "assets_vk.h"
+#include "batch.h"
+#include "bench.h"
+#include "options.h"
+#include "scene.h"
+#include "snapshot.h"
 #include "window.h"
 
 static SulfurTexture sprite_texture = {0};
@@ -20,15 +25,81 @@ static SulfurShader sprite_shaders[2];
 static SulfurBuffer sprite_vertex_buffer = {0};
 static SulfurBuffer sprite_index_buffer = {0};
 
-void sprite_init(SulfurDevice *dev) {
-  assets_vk_create_shader(dev, "shaders/sprite.vert.spv",
+// Ghosts: the bird quad drawn once per ghost, moved down by an offset per
+// instance. Command buffers are recorded once, so the draw reads how many
+// ghosts there are from a buffer written every frame.
+static SulfurShader ghost_shaders[2];
+static SulfurBuffer ghost_vertex_buffer = {0};
+static SulfurBuffer ghost_offset_buffer = {0};
+static SulfurBuffer ghost_draw_buffer = {0};
+
+static void init_ghosts(SulfurDevice *dev, Arena *arena) {
+  if (options_get()->ghosts == NULL) {
+    return;
+  }
+
+  assets_vk_create_shader(dev, arena, "shaders/sprite_ghost.vert.spv",
+                          VK_SHADER_STAGE_VERTEX_BIT, &ghost_shaders[0]);
+
+  assets_vk_create_shader(dev, arena, "shaders/sprite_ghost.frag.spv",
+                          VK_SHADER_STAGE_FRAGMENT_BIT, &ghost_shaders[1]);
+
+  // The fragment shader takes its opacity as specialization constant 0.
+  static const float opacity = kGhostOpacity;
+  static const VkSpecializationMapEntry opacity_entry = {
+      .constantID = 0, .offset = 0, .size = sizeof(opacity)};
+  static const VkSpecializationInfo ghost_specialization = {
+      .mapEntryCount = 1,
+      .pMapEntries = &opacity_entry,
+      .dataSize = sizeof(opacity),
+      .pData = &opacity};
+  ghost_shaders[1].pSpecializationInfo = &ghost_specialization;
+
+  Sprite ghost = {0};
+  scene_build_ghost(&ghost);
+
+  sulfur_buffer_create(dev, sizeof(ghost), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                           VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                       &ghost_vertex_buffer);
+  sulfur_buffer_write(&ghost, &ghost_vertex_buffer);
+
+  sulfur_buffer_create(dev, sizeof(float) * kMaxGhosts,
+                       VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                           VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                       &ghost_offset_buffer);
+
+  sulfur_buffer_create(dev, sizeof(VkDrawIndexedIndirectCommand),
+                       VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                           VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                       &ghost_draw_buffer);
+}
+
+static void quit_ghosts(SulfurDevice *dev) {
+  if (options_get()->ghosts == NULL) {
+    return;
+  }
+
+  sulfur_buffer_destroy(dev, &ghost_vertex_buffer);
+  sulfur_buffer_destroy(dev, &ghost_offset_buffer);
+  sulfur_buffer_destroy(dev, &ghost_draw_buffer);
+
+  for (uint32_t i = 0; i < 2; i++) {
+    sulfur_shader_destroy(dev, &ghost_shaders[i]);
+  }
+}
+
+void sprite_vk_init(SulfurDevice *dev, Arena *arena) {
+  assets_vk_create_shader(dev, arena, "shaders/sprite.vert.spv",
                           VK_SHADER_STAGE_VERTEX_BIT, &sprite_shaders[0]);
 
-  assets_vk_create_shader(dev, "shaders/sprite.frag.spv",
+  assets_vk_create_shader(dev, arena, "shaders/sprite.frag.spv",
                           VK_SHADER_STAGE_FRAGMENT_BIT, &sprite_shaders[1]);
 
-  assets_vk_create_texture(dev, "images/atlas.png", VK_FORMAT_R8G8B8A8_UNORM,
-                           &sprite_texture);
+  assets_vk_create_texture(dev, arena, "images/atlas.png",
+                           VK_FORMAT_R8G8B8A8_UNORM, &sprite_texture);
 
   VkDescriptorSetLayoutBinding descriptor_layout_binding = {
       .binding = 0,
@@ -62,8 +133,12 @@ void sprite_init(SulfurDevice *dev) {
         "Error initializing sprite descriptor sets: vkCreatePipelineLayout");
   }
 
-  // Create vertex buffer
-  sulfur_buffer_create(dev, sizeof(vertices), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+  // Create vertex buffer, with room for every game of a batch
+  VkDeviceSize vertex_size = sizeof(vertices);
+  if (batch_is_running()) {
+    vertex_size = sizeof(Sprite) * kNumSprites * batch_get_count();
+  }
+  sulfur_buffer_create(dev, vertex_size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
                            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
                        &sprite_vertex_buffer);
@@ -85,11 +160,15 @@ void sprite_init(SulfurDevice *dev) {
 
   sulfur_buffer_copy(dev, &tmp_buf, &sprite_index_buffer);
   sulfur_buffer_destroy(dev, &tmp_buf);
+
+  init_ghosts(dev, arena);
 }
 
-void sprite_quit(SulfurDevice *dev) {
+void sprite_vk_quit(SulfurDevice *dev) {
   vkDeviceWaitIdle(dev->device);
 
+  quit_ghosts(dev);
+
   sulfur_buffer_destroy(dev, &sprite_vertex_buffer);
   sulfur_buffer_destroy(dev, &sprite_index_buffer);
 
@@ -135,6 +214,84 @@ void sprite_get_pipeline_create_info(
       &sprite_vertex_attribute;
 
   pipeline_info->pVertexInputState = &sprite_vertex_input_info;
+
+  // Viewport and scissor are set when recording command buffers
+  // so that the pipeline survives swapchain recreation.
+  static const VkDynamicState sprite_dynamic_states[] = {
+      VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+
+  static VkPipelineDynamicStateCreateInfo sprite_dynamic_state_info = {0};
+  sprite_dynamic_state_info.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+  sprite_dynamic_state_info.dynamicStateCount = 2;
+  sprite_dynamic_state_info.pDynamicStates = sprite_dynamic_states;
+
+  pipeline_info->pDynamicState = &sprite_dynamic_state_info;
+}
+
+int sprite_get_ghost_pipeline_create_info(
+    VkGraphicsPipelineCreateInfo *pipeline_info) {
+  if (options_get()->ghosts == NULL || batch_is_running()) {
+    return 0;
+  }
+
+  // Same layout and dynamic state as the sprites
+  sprite_get_pipeline_create_info(pipeline_info);
+
+  pipeline_info->pStages = ghost_shaders;
+
+  // The quad per vertex, its offset per ghost
+  static VkVertexInputBindingDescription ghost_vertex_bindings[2] = {0};
+  ghost_vertex_bindings[0].binding = 0;
+  ghost_vertex_bindings[0].stride = 4 * sizeof(float);
+  ghost_vertex_bindings[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+  ghost_vertex_bindings[1].binding = 1;
+  ghost_vertex_bindings[1].stride = sizeof(float);
+  ghost_vertex_bindings[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+  static VkVertexInputAttributeDescription ghost_vertex_attributes[2] = {0};
+  ghost_vertex_attributes[0].location = 0;
+  ghost_vertex_attributes[0].binding = 0;
+  ghost_vertex_attributes[0].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+  ghost_vertex_attributes[1].location = 1;
+  ghost_vertex_attributes[1].binding = 1;
+  ghost_vertex_attributes[1].format = VK_FORMAT_R32_SFLOAT;
+
+  static VkPipelineVertexInputStateCreateInfo ghost_vertex_input_info = {0};
+  ghost_vertex_input_info.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+  ghost_vertex_input_info.vertexBindingDescriptionCount = 2;
+  ghost_vertex_input_info.pVertexBindingDescriptions = ghost_vertex_bindings;
+  ghost_vertex_input_info.vertexAttributeDescriptionCount = 2;
+  ghost_vertex_input_info.pVertexAttributeDescriptions =
+      ghost_vertex_attributes;
+
+  pipeline_info->pVertexInputState = &ghost_vertex_input_info;
+
+  // Translucent over the sprites, as glBlendFunc does on OpenGL
+  static VkPipelineColorBlendAttachmentState ghost_blend_attachment = {0};
+  ghost_blend_attachment.blendEnable = VK_TRUE;
+  ghost_blend_attachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+  ghost_blend_attachment.dstColorBlendFactor =
+      VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+  ghost_blend_attachment.colorBlendOp = VK_BLEND_OP_ADD;
+  ghost_blend_attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+  ghost_blend_attachment.dstAlphaBlendFactor =
+      VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+  ghost_blend_attachment.alphaBlendOp = VK_BLEND_OP_ADD;
+  ghost_blend_attachment.colorWriteMask =
+      VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+      VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+  static VkPipelineColorBlendStateCreateInfo ghost_blend_info = {0};
+  ghost_blend_info.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+  ghost_blend_info.attachmentCount = 1;
+  ghost_blend_info.pAttachments = &ghost_blend_attachment;
+
+  pipeline_info->pColorBlendState = &ghost_blend_info;
+
+  return 1;
 }
 
 VkPipelineLayout sprite_get_pipeline_layout() { return sprite_pipeline_layout; }
@@ -143,16 +300,82 @@ VkDescriptorSetLayout sprite_get_descriptor_set_layout(void) {
   return sprite_descriptor_set_layout;
 }
 
-void sprite_update() {
-  sulfur_buffer_write(vertices, &sprite_vertex_buffer);
+void sprite_vk_update() {
+  if (batch_is_running()) {
+    sulfur_buffer_write(batch_get_sprites(), &sprite_vertex_buffer);
+  } else {
+    const Snapshot *snapshot = snapshot_get();
+    sulfur_buffer_write(snapshot->sprites, &sprite_vertex_buffer);
+
+    if (options_get()->ghosts != NULL) {
+      const VkDrawIndexedIndirectCommand ghost_draw = {
+          .indexCount = kIndicesPerSprite,
+          .instanceCount = (uint32_t)snapshot->ghost_count};
+      sulfur_buffer_write(snapshot->ghost_ys, &ghost_offset_buffer);
+      sulfur_buffer_write(&ghost_draw, &ghost_draw_buffer);
+    }
+  }
+}
+
+/**
+ * Draw every game of the batch into its own tile of `extent`.
+ * Games share the index buffer and each starts `kNumSprites` sprites
+ * further into the vertex buffer.
+ */
+static void record_batch(VkCommandBuffer cmd_buf, VkExtent2D extent) {
+  for (int i = 0; i < batch_get_count(); i++) {
+    BatchTile tile;
+    batch_get_tile(i, (int)extent.width, (int)extent.height, &tile);
+
+    const VkViewport viewport = {.x = (float)tile.x,
+                                 .y = (float)tile.y,
+                                 .width = (float)tile.width,
+                                 .height = (float)tile.height,
+                                 .minDepth = 0.F,
+                                 .maxDepth = 1.F};
+    const VkRect2D scissor = {
+        .offset = {tile.x, tile.y},
+        .extent = {(uint32_t)tile.width, (uint32_t)tile.height}};
+    vkCmdSetViewport(cmd_buf, 0, 1, &viewport);
+    vkCmdSetScissor(cmd_buf, 0, 1, &scissor);
+
+    vkCmdDrawIndexed(cmd_buf, kIndicesPerSprite * kNumSprites, 1, 0,
+                     i * 4 * kNumSprites, 0);
+  }
 }
 
-void sprite_record_command_buffer(VkCommandBuffer cmd_buf) {
+/**
+ * Draw every ghost of the latest snapshot over the sprites.
+ */
+static void record_ghosts(VkCommandBuffer cmd_buf, VkPipeline ghost_pipeline) {
+  vkCmdBindPipeline(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, ghost_pipeline);
+
+  const VkBuffer buffers[2] = {ghost_vertex_buffer.buffer,
+                               ghost_offset_buffer.buffer};
+  const VkDeviceSize offsets[2] = {0, 0};
+  vkCmdBindVertexBuffers(cmd_buf, 0, 2, buffers, offsets);
+
+  vkCmdDrawIndexedIndirect(cmd_buf, ghost_draw_buffer.buffer, 0, 1,
+                           sizeof(VkDrawIndexedIndirectCommand));
+}
+
+void sprite_record_command_buffer(VkCommandBuffer cmd_buf, VkExtent2D extent,
+                                  VkPipeline ghost_pipeline) {
   VkDeviceSize offset = 0;
   vkCmdBindVertexBuffers(cmd_buf, 0, 1, &sprite_vertex_buffer.buffer, &offset);
   vkCmdBindIndexBuffer(cmd_buf, sprite_index_buffer.buffer, 0,
                        VK_INDEX_TYPE_UINT16);
-  vkCmdDrawIndexed(cmd_buf, kIndicesPerSprite * kNumSprites, 1, 0, 0, 0);
+  if (batch_is_running()) {
+    record_batch(cmd_buf, extent);
+  } else {
+    // One draw per repeat, the same calls as the other backends make.
+    for (int i = 0; i < bench_get_repeat(); i++) {
+      vkCmdDrawIndexed(cmd_buf, kIndicesPerSprite * kNumSprites, 1, 0, 0, 0);
+    }
+    if (ghost_pipeline != VK_NULL_HANDLE) {
+      record_ghosts(cmd_buf, ghost_pipeline);
+    }
+  }
 }
 
 void sprite_create_descriptor(SulfurDevice *dev,
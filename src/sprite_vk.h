@@ -1,17 +1,23 @@
 #pragma once
+#include "arena.h"
 #include "sprite.h"
 #include <sulfur/device.h>
 #include <vulkan/vulkan.h>
 
 /**
- * Load shaders and resources.
+ * Load shaders and resources, using `arena` for scratch memory.
  */
-void sprite_init(SulfurDevice *dev);
+void sprite_vk_init(SulfurDevice *dev, Arena *arena);
 
 /**
  * Free shaders and resources.
  */
-void sprite_quit(SulfurDevice *device);
+void sprite_vk_quit(SulfurDevice *device);
+
+/**
+ * Upload the latest snapshot, or every game of a batch render.
+ */
+void sprite_vk_update(void);
 
 /**
  * Build pipeline create info.
@@ -19,6 +25,13 @@ void sprite_quit(SulfurDevice *device);
 void sprite_get_pipeline_create_info(
     VkGraphicsPipelineCreateInfo *pipeline_info);
 
+/**
+ * Build the ghost pipeline create info on top of a default one.
+ * Return 0 if there are no ghosts to draw.
+ */
+int sprite_get_ghost_pipeline_create_info(
+    VkGraphicsPipelineCreateInfo *pipeline_info);
+
 VkPipelineLayout sprite_get_pipeline_layout(void);
 
 /**
@@ -33,6 +46,9 @@ void sprite_create_descriptor(SulfurDevice *dev,
                               VkDescriptorSet descriptor_set);
 
 /*
- * Record command buffers.
+ * Record command buffers drawing into a target of size `extent`.
+ * A batch render is tiled over it with one viewport per game.
+ * Ghosts are drawn with `ghost_pipeline` unless it is VK_NULL_HANDLE.
  */
-void sprite_record_command_buffer(VkCommandBuffer cmd_buf);
+void sprite_record_command_buffer(VkCommandBuffer cmd_buf, VkExtent2D extent,
+                                  VkPipeline ghost_pipeline);
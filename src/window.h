@@ -2,19 +2,30 @@
 
 /**
  * A window for rendering.
+ * Each backend opens it with its own `window_*_init`.
  */
-void window_init();
-
 void window_quit();
 
 void window_update();
 
+/**
+ * Block until an event arrives or `timeout` seconds have passed.
+ */
+void window_wait_events(float timeout);
+
+/**
+ * Make a pending `window_wait_events` return.
+ * Can be called from any thread.
+ */
+void window_wake();
+
+/**
+ * Whether the window contents were lost or resized since the last call.
+ */
+int window_needs_redraw();
+
 void window_fail_with_error(const char *message);
 
 int window_should_close();
 
 float window_get_time();
-
-int window_get_thrust();
-
-int window_get_pause();
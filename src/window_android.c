@@ -1,18 +1,30 @@
 #include "window_android.h"
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
 #include <android_native_app_glue.h>
 
-int main(void);
+#include "bench.h"
+#include "input.h"
+
+int main(int argc, char **argv);
 
 static struct android_app *flap_app;
 static int window_ready = 0;
 static int should_close = 0;
-static int thrust = 0;
-static int pause = 0;
+static int needs_redraw = 0;
+
+// Times are relative to startup to keep float precision.
+static int64_t start_time = 0;
+
+static int64_t get_monotonic_time() {
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return (int64_t)time.tv_sec * 1000000000 + time.tv_nsec;
+}
 
 struct android_app *android_window_get_app() {
   return flap_app;
@@ -22,11 +34,16 @@ static void on_app_cmd(struct android_app *app, int32_t cmd) {
   switch (cmd) {
   case APP_CMD_INIT_WINDOW:
     window_ready = 1;
-    pause = 0;
     break;
   case APP_CMD_TERM_WINDOW:
     should_close = 1;
     break;
+  case APP_CMD_WINDOW_RESIZED:
+  case APP_CMD_WINDOW_REDRAW_NEEDED:
+  case APP_CMD_CONTENT_RECT_CHANGED:
+  case APP_CMD_GAINED_FOCUS:
+    needs_redraw = 1;
+    break;
   default:
     break;
   }
@@ -34,9 +51,13 @@ static void on_app_cmd(struct android_app *app, int32_t cmd) {
 
 static int32_t on_input_event(struct android_app *app, AInputEvent *event) {
   if (AInputEvent_getType(event) == AINPUT_EVENT_TYPE_MOTION) {
-    int32_t action = AMotionEvent_getAction(event);
-    if (action == AKEY_EVENT_ACTION_DOWN) {
-      thrust = 1;
+    const int32_t action =
+        AMotionEvent_getAction(event) & AMOTION_EVENT_ACTION_MASK;
+    if (action == AMOTION_EVENT_ACTION_DOWN ||
+        action == AMOTION_EVENT_ACTION_POINTER_DOWN) {
+      // Event times are on CLOCK_MONOTONIC like `window_get_time`.
+      const int64_t event_time = AMotionEvent_getEventTime(event);
+      input_push(INPUT_THRUST, (float)(event_time - start_time) / 1e9F);
     }
     return 1;
   }
@@ -47,21 +68,23 @@ void android_main(struct android_app *app) {
   app->onAppCmd = on_app_cmd;
   app->onInputEvent = on_input_event;
   flap_app = app;
+  start_time = get_monotonic_time();
 
   while (!window_ready) {
     window_update();
   }
-  main();
+  main(0, NULL);
 }
 
-void window_update() {
-  thrust = 0;
-  pause = 0;
-
+/**
+ * Process pending events, waiting at most `timeout_ms` for the first one.
+ */
+static void poll_events(int timeout_ms) {
   int numEvents = 0;
   struct android_poll_source *source = NULL;
 
-  while (ALooper_pollAll(0, NULL, &numEvents, (void **)&source) >= 0) {
+  while (ALooper_pollAll(timeout_ms, NULL, &numEvents, (void **)&source) >=
+         0) {
     if (source != NULL) {
       source->process(flap_app, source);
     }
@@ -70,22 +93,34 @@ void window_update() {
       should_close = 1;
       return;
     }
+
+    // Only block for the first event.
+    timeout_ms = 0;
   }
 }
 
-int window_should_close() { return should_close; }
+void window_update() { poll_events(0); }
 
-float window_get_time() {
-  static const float second = 1000000000.F;
+void window_wait_events(float timeout) {
+  poll_events((int)(timeout * 1000.F));
+}
 
-  struct timespec time;
-  clock_gettime(CLOCK_MONOTONIC, &time);
-  return (time.tv_sec * second + (float)time.tv_nsec) / second;
+void window_wake() { ALooper_wake(flap_app->looper); }
+
+int window_needs_redraw() {
+  const int redraw = needs_redraw;
+  needs_redraw = 0;
+  return redraw;
 }
 
-int window_get_thrust() { return thrust; }
+int window_should_close() { return should_close; }
 
-int window_get_pause() { return pause; }
+float window_get_time() {
+  if (bench_is_running()) {
+    return bench_get_time();
+  }
+  return (float)(get_monotonic_time() - start_time) / 1e9F;
+}
 
 /**
  * Display an error message through
@@ -1,14 +1,20 @@
 #include "window_android.h"
+#include "window_gl.h"
 
 #include <EGL/egl.h>
 #include <android/log.h>
 #include <glad/glad.h>
 
+#include "options.h"
+
 static EGLDisplay display = EGL_NO_DISPLAY;
 static EGLSurface surface = EGL_NO_SURFACE;
 static EGLContext context = EGL_NO_CONTEXT;
 
-void window_init() {
+// Only one backend is built for Android: there is nothing to compare.
+double window_gl_probe(double (*time_frames)(void)) { return 0.; }
+
+void window_gl_init() {
   display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
 
   eglInitialize(display, NULL, NULL);
@@ -53,6 +59,13 @@ void window_init() {
   }
 
   int ok = gladLoadGLES2Loader((GLADloadproc)eglGetProcAddress);
+
+  // EGL has no tearing mode: anything but FIFO disables vsync.
+  const PresentMode present_mode = options_get()->present_mode;
+  eglSwapInterval(display, present_mode == PRESENT_MODE_FIFO ||
+                                   present_mode == PRESENT_MODE_FIFO_RELAXED
+                               ? 1
+                               : 0);
 }
 
 void window_quit() {
@@ -61,6 +74,8 @@ void window_quit() {
   eglTerminate(display);
 }
 
+void window_gl_swap_buffers() { eglSwapBuffers(display, surface); }
+
 GLAPI void APIENTRY window_gl_debug_message_callback(GLenum source, GLenum type,
                                                      GLuint id, GLenum severity,
                                                      GLsizei length,
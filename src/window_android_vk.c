@@ -1,11 +1,15 @@
 #include "window_android.h"
+#include "window_vk.h"
 
 #include <android/log.h>
 
 #include <vulkan/vulkan.h>
 #include <vulkan/vulkan_android.h>
 
-void window_init() {}
+void window_vk_init() {}
+
+// Only one backend is built for Android: there is nothing to compare.
+double window_vk_probe(double (*time_frames)(void)) { return 0.; }
 
 void window_quit() {}
 
@@ -9,21 +9,22 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "bench.h"
+#include "input.h"
+#include "options.h"
+
 static const char *kFlapWindowTitle = "Flap";
 static const int kFlapWindowWidth = 800;
 static const int kFlapWindowHeight = 450;
 
 GLFWwindow *window = NULL;
-static int thrust = 0;
-static int pause = 0;
+static int needs_redraw = 0;
 
 int window_should_close() { return glfwWindowShouldClose(window); }
 
-float window_get_time() { return (float)glfwGetTime(); }
-
-int window_get_thrust() { return thrust; }
-
-int window_get_pause() { return pause; }
+float window_get_time() {
+  return bench_is_running() ? bench_get_time() : (float)glfwGetTime();
+}
 
 void window_fail_with_error(const char *error) {
 #ifdef _WIN32
@@ -42,9 +43,9 @@ void window_desktop_error_callback(int error, const char *description) {
 void window_desktop_key_callback(GLFWwindow *window, int key, int scancode,
                                  int action, int mods) {
   if (key == GLFW_KEY_SPACE && action == GLFW_PRESS) {
-    thrust = 1;
+    input_push(INPUT_THRUST, window_get_time());
   } else if (key == GLFW_KEY_P && action == GLFW_PRESS) {
-    pause = 1;
+    input_push(INPUT_PAUSE, window_get_time());
   } else if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
     glfwSetWindowShouldClose(window, GLFW_TRUE);
   }
@@ -53,17 +54,39 @@ void window_desktop_key_callback(GLFWwindow *window, int key, int scancode,
 void window_desktop_mouse_button_callback(GLFWwindow *window, int button,
                                           int action, int mods) {
   if (action == GLFW_PRESS) {
-    thrust = 1;
+    input_push(INPUT_THRUST, window_get_time());
   }
 }
 
-void window_update() {
-  thrust = 0;
-  pause = 0;
-  glfwPollEvents();
-#ifdef FLAP_USE_OPENGL
-  glfwSwapBuffers(window);
-#endif
+void window_desktop_refresh_callback(GLFWwindow *window) { needs_redraw = 1; }
+
+int window_desktop_get_swap_interval() {
+  // OpenGL has no mailbox mode: it gets an uncapped swap like immediate.
+  switch (options_get()->present_mode) {
+  case PRESENT_MODE_FIFO_RELAXED:
+    if (glfwExtensionSupported("WGL_EXT_swap_control_tear") ||
+        glfwExtensionSupported("GLX_EXT_swap_control_tear")) {
+      return -1;
+    }
+    return 1;
+  case PRESENT_MODE_MAILBOX:
+  case PRESENT_MODE_IMMEDIATE:
+    return 0;
+  default:
+    return 1;
+  }
+}
+
+void window_update() { glfwPollEvents(); }
+
+void window_wait_events(float timeout) { glfwWaitEventsTimeout(timeout); }
+
+void window_wake() { glfwPostEmptyEvent(); }
+
+int window_needs_redraw() {
+  const int redraw = needs_redraw;
+  needs_redraw = 0;
+  return redraw;
 }
 
 void window_quit() {
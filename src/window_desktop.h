@@ -16,3 +16,11 @@ void window_desktop_key_callback(GLFWwindow *window, int key, int scancode,
 
 void window_desktop_mouse_button_callback(GLFWwindow *window, int button,
                                           int action, int mods);
+
+void window_desktop_refresh_callback(GLFWwindow *window);
+
+/**
+ * Map the present mode onto a swap interval.
+ * Needs a current OpenGL context.
+ */
+int window_desktop_get_swap_interval(void);
@@ -4,21 +4,59 @@
 
 #include <stdio.h>
 
+#include "alloc.h"
+
 static void on_resize(GLFWwindow *window, int width, int height) {
   glViewport(0, 0, width, height);
+
+  // The driver reallocates the back buffer.
+  alloc_skip_frame();
+}
+
+static void set_context_hints(void) {
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
+}
+
+double window_gl_probe(double (*time_frames)(void)) {
+  // Failing is an answer here, not an error.
+  glfwSetErrorCallback(NULL);
+
+  if (!glfwInit()) {
+    return -1.;
+  }
+
+  set_context_hints();
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+  double frame_time = -1.;
+  window = glfwCreateWindow(FLAP_WINDOW_WIDTH, FLAP_WINDOW_HEIGHT,
+                            FLAP_WINDOW_TITLE, NULL, NULL);
+  if (window != NULL) {
+    glfwMakeContextCurrent(window);
+    if (gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+      // Time drawing, not waiting for the display.
+      glfwSwapInterval(0);
+      frame_time = time_frames();
+    }
+    glfwDestroyWindow(window);
+    window = NULL;
+  }
+
+  glfwTerminate();
+  return frame_time;
 }
 
-void window_init() {
+void window_gl_init() {
   if (!glfwInit()) {
     window_fail_with_error("An error occurred while initializing GLFW.");
   }
 
   glfwSetErrorCallback(window_desktop_error_callback);
 
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-  glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
+  set_context_hints();
 
   window = glfwCreateWindow(FLAP_WINDOW_WIDTH, FLAP_WINDOW_HEIGHT,
                             FLAP_WINDOW_TITLE, NULL, NULL);
@@ -29,14 +67,17 @@ void window_init() {
     window_fail_with_error("Failed to load OpenGL!");
   }
 
-  glfwSwapInterval(1);
+  glfwSwapInterval(window_desktop_get_swap_interval());
 
   glfwSetWindowSizeCallback(window, on_resize);
 
   glfwSetKeyCallback(window, window_desktop_key_callback);
   glfwSetMouseButtonCallback(window, window_desktop_mouse_button_callback);
+  glfwSetWindowRefreshCallback(window, window_desktop_refresh_callback);
 }
 
+void window_gl_swap_buffers() { glfwSwapBuffers(window); }
+
 GLAPI void APIENTRY window_gl_debug_message_callback(GLenum source, GLenum type,
                                                      GLuint id, GLenum severity,
                                                      GLsizei length,
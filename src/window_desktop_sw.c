@@ -0,0 +1,171 @@
+#include "window_sw.h"
+
+#include <stddef.h>
+
+#include <glad/glad.h>
+
+#include "window_desktop.h"
+
+#include "options.h"
+
+// Blit source for windowed mode: the frame as a texture.
+static GLuint texture = 0;
+static GLuint read_framebuffer = 0;
+static int texture_width = 0;
+static int texture_height = 0;
+
+static unsigned int presented_frames = 0;
+
+/**
+ * Only for presenting: blitting needs OpenGL 3.0, no shaders.
+ */
+static void set_context_hints(void) {
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
+}
+
+/**
+ * Create the texture frames are blitted from.
+ */
+static void create_blit_source(void) {
+  glGenTextures(1, &texture);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+  glGenFramebuffers(1, &read_framebuffer);
+}
+
+double window_sw_probe(double (*time_frames)(void)) {
+  // Failing is an answer here, not an error.
+  glfwSetErrorCallback(NULL);
+
+  if (!glfwInit()) {
+    return -1.;
+  }
+
+  set_context_hints();
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+  double frame_time = -1.;
+  window = glfwCreateWindow(FLAP_WINDOW_WIDTH, FLAP_WINDOW_HEIGHT,
+                            FLAP_WINDOW_TITLE, NULL, NULL);
+  if (window != NULL) {
+    glfwMakeContextCurrent(window);
+    if (gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+      // Time drawing, not waiting for the display.
+      glfwSwapInterval(0);
+      create_blit_source();
+      frame_time = time_frames();
+
+      glDeleteFramebuffers(1, &read_framebuffer);
+      glDeleteTextures(1, &texture);
+      texture_width = 0;
+      texture_height = 0;
+      presented_frames = 0;
+    }
+    glfwDestroyWindow(window);
+    window = NULL;
+  }
+
+  glfwTerminate();
+  return frame_time;
+}
+
+void window_sw_init() {
+  const char *headless = options_get()->headless;
+
+#ifdef GLFW_PLATFORM_NULL
+  // No display needed to run headless.
+  if (headless != NULL) {
+    glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+  }
+#endif
+
+  if (!glfwInit()) {
+    window_fail_with_error("An error occurred while initializing GLFW.");
+  }
+
+  glfwSetErrorCallback(window_desktop_error_callback);
+
+  if (headless != NULL) {
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  } else {
+    set_context_hints();
+  }
+
+  window = glfwCreateWindow(FLAP_WINDOW_WIDTH, FLAP_WINDOW_HEIGHT,
+                            FLAP_WINDOW_TITLE, NULL, NULL);
+
+  if (headless == NULL) {
+    glfwMakeContextCurrent(window);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+      window_fail_with_error("Failed to load OpenGL!");
+    }
+
+    glfwSwapInterval(window_desktop_get_swap_interval());
+
+    create_blit_source();
+  }
+
+  glfwSetKeyCallback(window, window_desktop_key_callback);
+  glfwSetMouseButtonCallback(window, window_desktop_mouse_button_callback);
+  glfwSetWindowRefreshCallback(window, window_desktop_refresh_callback);
+}
+
+void window_sw_get_size(int *width, int *height) {
+  if (options_get()->headless != NULL) {
+    *width = FLAP_WINDOW_WIDTH;
+    *height = FLAP_WINDOW_HEIGHT;
+  } else {
+    glfwGetFramebufferSize(window, width, height);
+  }
+}
+
+void window_sw_draw(const uint32_t *pixels, int width, int height) {
+  if (width == 0 || height == 0) {
+    return;
+  }
+
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, read_framebuffer);
+
+  if (width != texture_width || height != texture_height) {
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, pixels);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                           GL_TEXTURE_2D, texture, 0);
+    texture_width = width;
+    texture_height = height;
+  } else {
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA,
+                    GL_UNSIGNED_BYTE, pixels);
+  }
+
+  // Rows start at the top here and at the bottom in OpenGL: flip.
+  int window_width = 0;
+  int window_height = 0;
+  glfwGetFramebufferSize(window, &window_width, &window_height);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+  glBlitFramebuffer(0, 0, width, height, 0, window_height, window_width, 0,
+                    GL_COLOR_BUFFER_BIT, GL_NEAREST);
+}
+
+void window_sw_present() {
+  if (options_get()->headless != NULL) {
+    // Every frame counts in a capture, even frozen ones.
+    window_desktop_refresh_callback(window);
+  } else {
+    glfwSwapBuffers(window);
+  }
+
+  presented_frames++;
+  if (options_get()->frames > 0 &&
+      presented_frames >= (unsigned int)options_get()->frames) {
+    glfwSetWindowShouldClose(window, GLFW_TRUE);
+  }
+}
@@ -1,11 +1,137 @@
-#include "window_desktop.h"
+// Vulkan first so that GLFW declares its Vulkan functions.
 #include "window_vk.h"
+#include "window_desktop.h"
+
+#include <sulfur/device.h>
 
+#include <stdint.h>
 #include <stdio.h>
 
 #include <GLFW/glfw3.h>
 
-void window_init() {
+/**
+ * Find a queue family that can draw and present to a window.
+ */
+static int find_queue_family(VkInstance instance, VkPhysicalDevice device,
+                             uint32_t *family) {
+  VkQueueFamilyProperties properties[16];
+  uint32_t property_count = 16;
+  vkGetPhysicalDeviceQueueFamilyProperties(device, &property_count,
+                                           properties);
+
+  for (uint32_t i = 0; i < property_count; i++) {
+    if ((properties[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) &&
+        glfwGetPhysicalDevicePresentationSupport(instance, device, i)) {
+      *family = i;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Check that sulfur picks a device for the surface, the same one the game
+ * would then draw with.
+ */
+static int probe_device(VkInstance instance, VkSurfaceKHR surface) {
+  VkPhysicalDevice devices[8];
+  uint32_t device_count = 8;
+  vkEnumeratePhysicalDevices(instance, &device_count, devices);
+
+  // Sulfur expects some device to be able to present.
+  int presentable = 0;
+  for (uint32_t i = 0; i < device_count && !presentable; i++) {
+    uint32_t family = 0;
+    presentable = find_queue_family(instance, devices[i], &family);
+  }
+  if (!presentable) {
+    return 0;
+  }
+
+  SulfurDevice device = {0};
+  sulfur_device_create(instance, surface, &device);
+  if (device.device == VK_NULL_HANDLE) {
+    return 0;
+  }
+  sulfur_device_destroy(&device);
+  return 1;
+}
+
+/**
+ * Create an instance and a surface on a hidden window to probe devices
+ * with.
+ */
+static int probe_instance(void) {
+  uint32_t extension_count = 0;
+  const char **extensions = glfwGetRequiredInstanceExtensions(&extension_count);
+  if (extensions == NULL) {
+    return 0;
+  }
+
+  static const VkApplicationInfo app_info = {
+      .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
+      .pApplicationName = "Flap",
+      .applicationVersion = VK_MAKE_VERSION(1, 0, 0),
+      .apiVersion = VK_MAKE_VERSION(1, 0, 0)};
+
+  const VkInstanceCreateInfo instance_info = {
+      .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+      .pApplicationInfo = &app_info,
+      .enabledExtensionCount = extension_count,
+      .ppEnabledExtensionNames = extensions};
+
+  VkInstance instance = VK_NULL_HANDLE;
+  if (vkCreateInstance(&instance_info, NULL, &instance) != VK_SUCCESS) {
+    return 0;
+  }
+
+  glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+  int ok = 0;
+  GLFWwindow *hidden = glfwCreateWindow(FLAP_WINDOW_WIDTH, FLAP_WINDOW_HEIGHT,
+                                        FLAP_WINDOW_TITLE, NULL, NULL);
+  if (hidden != NULL) {
+    VkSurfaceKHR surface = VK_NULL_HANDLE;
+    if (glfwCreateWindowSurface(instance, hidden, NULL, &surface) ==
+        VK_SUCCESS) {
+      ok = probe_device(instance, surface);
+      vkDestroySurfaceKHR(instance, surface, NULL);
+    }
+    glfwDestroyWindow(hidden);
+  }
+
+  vkDestroyInstance(instance, NULL);
+  return ok;
+}
+
+double window_vk_probe(double (*time_frames)(void)) {
+  // Failing is an answer here, not an error.
+  glfwSetErrorCallback(NULL);
+
+  if (!glfwInit()) {
+    return -1.;
+  }
+
+  double frame_time = -1.;
+  if (glfwVulkanSupported() && probe_instance()) {
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    window = glfwCreateWindow(FLAP_WINDOW_WIDTH, FLAP_WINDOW_HEIGHT,
+                              FLAP_WINDOW_TITLE, NULL, NULL);
+    if (window != NULL) {
+      frame_time = time_frames();
+      glfwDestroyWindow(window);
+      window = NULL;
+    }
+  }
+
+  glfwTerminate();
+  return frame_time;
+}
+
+void window_vk_init() {
   if (!glfwInit()) {
     window_fail_with_error("An error occurred while initializing GLFW.");
   }
@@ -17,6 +143,7 @@ void window_init() {
   window = glfwCreateWindow(FLAP_WINDOW_WIDTH, FLAP_WINDOW_HEIGHT,
                             FLAP_WINDOW_TITLE, NULL, NULL);
   glfwSetKeyCallback(window, window_desktop_key_callback);
+  glfwSetWindowRefreshCallback(window, window_desktop_refresh_callback);
 }
 
 VkSurfaceKHR window_vk_create_surface(const VkInstance instance) {
@@ -3,6 +3,24 @@
 #include "window.h"
 #include <glad/glad.h>
 
+/**
+ * Open the window with an OpenGL context.
+ */
+void window_gl_init(void);
+
+/**
+ * Create an OpenGL context in a hidden window, standing in for the
+ * game's, and time frames drawn into it with `time_frames`.
+ * Return seconds per frame, or a negative value if OpenGL is unavailable.
+ * GLFW is left terminated.
+ */
+double window_gl_probe(double (*time_frames)(void));
+
+/**
+ * Present the back buffer.
+ */
+void window_gl_swap_buffers(void);
+
 void APIENTRY window_gl_debug_message_callback(GLenum source, GLenum type,
                                                GLuint id, GLenum severity,
                                                GLsizei length,
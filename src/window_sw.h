@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "window.h"
+
+/**
+ * Open the window, or a hidden one when running headless.
+ */
+void window_sw_init(void);
+
+/**
+ * Open a hidden window that presents like the game's and time frames
+ * drawn into it with `time_frames`.
+ * Return seconds per frame, or a negative value if it cannot be opened.
+ * GLFW is left terminated.
+ */
+double window_sw_probe(double (*time_frames)(void));
+
+/**
+ * Size of the frames to draw, in pixels.
+ */
+void window_sw_get_size(int *width, int *height);
+
+/**
+ * Copy a frame of RGBA8 pixels, top row first, to the back buffer.
+ */
+void window_sw_draw(const uint32_t *pixels, int width, int height);
+
+/**
+ * Present the back buffer.
+ */
+void window_sw_present(void);
@@ -2,6 +2,20 @@
 #include "window.h"
 #include <vulkan/vulkan.h>
 
+/**
+ * Open the window for a Vulkan surface.
+ */
+void window_vk_init(void);
+
+/**
+ * Check that sulfur finds a Vulkan device that can present to a hidden
+ * window, then time frames drawn into one, standing in for the game's,
+ * with `time_frames`.
+ * Return seconds per frame, or a negative value if Vulkan is unavailable.
+ * GLFW is left terminated.
+ */
+double window_vk_probe(double (*time_frames)(void));
+
 VkSurfaceKHR window_vk_create_surface(const VkInstance instance);
 
 // Return an array of required Vulkan instance extensions.
@@ -0,0 +1,220 @@
+#include "world_internal.h"
+
+#include <stddef.h>
+
+#include "xoroshiro.h"
+
+/**
+ * Draw a random pipe height.
+ */
+static float random_pipe_height(World *world) {
+  xoroshiro128plus(world->random_state);
+  return kMinPipeHeight + (float)world->random_state[0] / UINT64_MAX *
+                              (kMaxPipeHeight - kMinPipeHeight);
+}
+
+/**
+ * Continuous collision detection.
+ * Move `b1` by (`dx`, `dy`) against a static `b2` and return the
+ * fraction of the move at which they first touch, in [0, 1].
+ * Return a value greater than 1 if they never touch.
+ */
+static float box_sweep(const Box *b1, float dx, float dy, const Box *b2) {
+  float t_enter = 0.F;
+  float t_exit = 1.F;
+
+  const float min1[2] = {b1->left, b1->top};
+  const float max1[2] = {b1->right, b1->bottom};
+  const float min2[2] = {b2->left, b2->top};
+  const float max2[2] = {b2->right, b2->bottom};
+  const float d[2] = {dx, dy};
+
+  for (int i = 0; i < 2; i++) {
+    if (d[i] == 0.F) {
+      if (!(min1[i] < max2[i] && min2[i] < max1[i])) {
+        return 2.F;
+      }
+    } else {
+      float t0 = (min2[i] - max1[i]) / d[i];
+      float t1 = (max2[i] - min1[i]) / d[i];
+      if (t0 > t1) {
+        const float t = t0;
+        t0 = t1;
+        t1 = t;
+      }
+      t_enter = t0 > t_enter ? t0 : t_enter;
+      t_exit = t1 < t_exit ? t1 : t_exit;
+    }
+  }
+
+  return t_enter < t_exit ? t_enter : 2.F;
+}
+
+/**
+ * Sweep the bird over the next `dt` against every pipe,
+ * in the pipes' frame of reference.
+ * Return the fraction of the step at which it first hits one,
+ * or a value greater than 1.
+ */
+static float sweep_pipes(const World *world, const float dt) {
+  const float dx = (world->speed_x - kScrollSpeed) * dt;
+  const float dy = world->speed_y * dt;
+
+  const Box bird = world_get_bird_box(world);
+
+  float hit = 2.F;
+  for (int i = 0; i < kNumPipes; i++) {
+    Box boxes[kSpritesPerPipe];
+    world_get_pipe_boxes(&world->pipes[i], boxes);
+
+    for (int j = 0; j < kSpritesPerPipe; j++) {
+      const float t = box_sweep(&bird, dx, dy, &boxes[j]);
+      if (t < hit) {
+        hit = t;
+      }
+    }
+  }
+  return hit;
+}
+
+void world_scroll_pipes(World *world, const float dt) {
+  for (int i = 0; i < kNumPipes; i++) {
+    world->pipes[i].x += kScrollSpeed * dt;
+  }
+}
+
+void world_recycle_pipes(World *world) {
+  Pipe *pipe = &world->pipes[world->next_pipe];
+  if (pipe->x + kPipeBodyX < kScreenLeft - kPipeWidth) {
+    world->pipe_gap =
+        kInitialPipeGap - (world->play_time / kDeadline) * kInitialPipeGap;
+
+    pipe->x = kScreenRight;
+    pipe->height = random_pipe_height(world);
+    pipe->gap = world->pipe_gap;
+
+    world->next_pipe = (world->next_pipe + 1) % kNumPipes;
+  }
+}
+
+static void move_bird(World *world, const float dt) {
+  world->bird_x += world->speed_x * dt;
+  world->bird_y += world->speed_y * dt;
+}
+
+void world_init(World *world, uint64_t seed0, uint64_t seed1) {
+  world->random_state[0] = seed0;
+  world->random_state[1] = seed1;
+  world->time = 0.F;
+  world->last_thrust = -kThrustDelay;
+
+  world_reset(world);
+}
+
+/**
+ * SplitMix64, to spread nearby seeds over the generator's whole state.
+ */
+static uint64_t split_mix(uint64_t *state) {
+  uint64_t z = (*state += 0x9e3779b97f4a7c15);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+  return z ^ (z >> 31);
+}
+
+void world_seed(World *world, const uint64_t seed) {
+  uint64_t state = seed;
+  const uint64_t seed0 = split_mix(&state);
+  const uint64_t seed1 = split_mix(&state);
+  world_init(world, seed0, seed1);
+}
+
+void world_reset(World *world) {
+  world->state = WORLD_PLAYING;
+
+  world->pipe_gap = kInitialPipeGap;
+
+  world->bird_x = kBirdX;
+  world->bird_y = kBirdY;
+
+  for (int i = 0; i < kNumPipes; i++) {
+    world->pipes[i].x = i * kPipeStep;
+    world->pipes[i].height = random_pipe_height(world);
+    world->pipes[i].gap = world->pipe_gap;
+  }
+  world->next_pipe = 0;
+
+  world->speed_x = 0.F;
+  world->speed_y = 0.F;
+
+  world->play_time = 0.F;
+}
+
+int world_thrust(World *world) {
+  if (world->state == WORLD_PLAYING &&
+      world->time - world->last_thrust > kThrustDelay) {
+    world->speed_y += kThrust;
+    world->last_thrust = world->time;
+    return 1;
+  } else if (world->state == WORLD_GAMEOVER) {
+    world_reset(world);
+  }
+  return 0;
+}
+
+const Pipe *world_get_next_pipe(const World *world) {
+  const Pipe *next = NULL;
+  for (int i = 0; i < kNumPipes; i++) {
+    const Pipe *pipe = &world->pipes[i];
+    if (pipe->x + kPipeWidth > world->bird_x &&
+        (next == NULL || pipe->x < next->x)) {
+      next = pipe;
+    }
+  }
+  return next;
+}
+
+void world_step(World *world, const float dt) {
+  world->time += dt;
+
+  switch (world->state) {
+  case WORLD_PLAYING: {
+    world->play_time += dt;
+
+    world->speed_y += kGravity * dt;
+
+    // Stop at the exact time of impact whatever the step size.
+    const float hit = sweep_pipes(world, dt);
+    if (hit <= 1.F) {
+      world_scroll_pipes(world, hit * dt);
+      move_bird(world, hit * dt);
+
+      world->state = WORLD_FALLING;
+      world->speed_x = -kFallSpeed;
+      world->speed_y = kFallSpeed;
+      return;
+    }
+
+    world_scroll_pipes(world, dt);
+    world_recycle_pipes(world);
+
+    if (world->bird_y < kScreenTop) {
+      world->state = WORLD_FALLING;
+      world->speed_x = -kFallSpeed;
+      world->speed_y = kFallSpeed;
+    } else if (world->bird_y > kScreenBottom) {
+      world->state = WORLD_GAMEOVER;
+    }
+    break;
+  }
+  case WORLD_FALLING:
+    world->speed_y += kGravity * dt;
+    if (world->bird_y > kScreenBottom) {
+      world->state = WORLD_GAMEOVER;
+    }
+    break;
+  default:
+    break;
+  }
+
+  move_bird(world, dt);
+}
@@ -0,0 +1,152 @@
+#ifndef FLAP_WORLD_H
+#define FLAP_WORLD_H
+
+#include <stdint.h>
+
+#include "sprite.h"
+
+// Vulkan coordinate system.
+#define kScreenTop -1.F
+#define kScreenBottom 1.F
+#define kScreenHeight 2.F
+#define kScreenLeft -1.F
+#define kScreenRight 1.F
+
+// Physics
+#define kGravity 2.F
+#define kThrust -0.75F
+#define kThrustDelay 0.1F
+#define kScrollSpeed -0.24F
+#define kFallSpeed 0.1F
+
+// Fixed simulation step
+#define kWorldTimeStep (1.F / 120.F)
+
+// Increase difficulty over time:
+// Game can't last more than 2 minutes.
+#define kDeadline 120.F
+
+// Bird
+#define kBirdX -0.75F
+#define kBirdY -0.5F
+#define kBirdWidth 0.08F
+#define kBirdHeight 0.14F
+
+// Pipes
+#define kPipeWidth 0.12F
+#define kMinPipeHeight 0.25F
+#define kMaxPipeHeight 1.F
+#define kInitialPipeGap 0.64F
+#define kPipeStep 0.5F
+#define kPipeHeadHeight (16.F / 32.F)
+
+// kPipeBodyWidth = kPipeBodyTextureWidth / kPipeHeadTextureWidth * kPipeWidth;
+#define kPipeBodyWidth 0.075F
+
+// kPipeBodyX = (kPipeWidth - kPipeBodyWidth) / 2.F;
+#define kPipeBodyX 0.0225F
+
+typedef enum { WORLD_PLAYING, WORLD_FALLING, WORLD_GAMEOVER } WorldState;
+
+/**
+ * An axis-aligned box, y pointing down.
+ */
+typedef struct Box {
+  float left;
+  float top;
+  float right;
+  float bottom;
+} Box;
+
+/**
+ * A pair of pipes with a gap in between.
+ */
+typedef struct Pipe {
+  float x;      // Left of the pipe heads
+  float height; // Height of the top pipe body
+  float gap;    // Space between the two pipe heads
+} Pipe;
+
+/**
+ * The whole simulation state.
+ * Plain data: copying a world is a snapshot of the game.
+ */
+typedef struct World {
+  uint64_t random_state[2];
+  WorldState state;
+  float time;      // Simulated seconds since `world_init`
+  float play_time; // Simulated seconds since the last reset
+  float last_thrust;
+  float bird_x;
+  float bird_y;
+  float speed_x;
+  float speed_y;
+  float pipe_gap;
+  int next_pipe;
+  Pipe pipes[kNumPipes];
+} World;
+
+/**
+ * Seed the random generator and start a new game.
+ */
+void world_init(World *world, uint64_t seed0, uint64_t seed1);
+
+/**
+ * Seed the random generator from a single number and start a new game.
+ */
+void world_seed(World *world, uint64_t seed);
+
+/**
+ * Start a new game, keeping the random generator going.
+ */
+void world_reset(World *world);
+
+/**
+ * Advance physics by `dt`.
+ */
+void world_step(World *world, float dt);
+
+/**
+ * Flap, or start over after game over.
+ * Return 1 if the bird flapped.
+ */
+int world_thrust(World *world);
+
+/**
+ * Get the first pipe the bird hasn't passed yet.
+ */
+const Pipe *world_get_next_pipe(const World *world);
+
+static inline Box world_get_bird_box(const World *world) {
+  const Box box = {world->bird_x, world->bird_y, world->bird_x + kBirdWidth,
+                   world->bird_y + kBirdHeight};
+  return box;
+}
+
+/**
+ * Get the boxes of a pipe, in sprite order:
+ * top body, top head, bottom head, bottom body.
+ */
+static inline void world_get_pipe_boxes(const Pipe *pipe, Box *boxes) {
+  const float head_height = kPipeHeadHeight * kPipeWidth;
+  const float top_head = kScreenTop + pipe->height;
+  const float bottom_head = top_head + pipe->gap;
+
+  const Box top_body = {pipe->x + kPipeBodyX, kScreenTop,
+                        pipe->x + kPipeBodyX + kPipeBodyWidth, top_head};
+  const Box top_head_box = {pipe->x, top_head, pipe->x + kPipeWidth,
+                            top_head + head_height};
+  const Box bottom_head_box = {pipe->x, bottom_head, pipe->x + kPipeWidth,
+                               bottom_head + head_height};
+  const Box bottom_body = {
+      pipe->x + kPipeBodyX, bottom_head + head_height,
+      pipe->x + kPipeBodyX + kPipeBodyWidth,
+      bottom_head + head_height + kScreenHeight - pipe->height - head_height};
+
+  boxes[0] = top_body;
+  boxes[1] = top_head_box;
+  boxes[2] = bottom_head_box;
+  boxes[3] = bottom_body;
+}
+
+#endif // FLAP_WORLD_H
@@ -0,0 +1,18 @@
+#ifndef FLAP_WORLD_INTERNAL_H
+#define FLAP_WORLD_INTERNAL_H
+
+#include "world.h"
+
+// Steps of `world_step`, exposed for the microbenchmarks.
+
+/**
+ * Move every pipe left by `dt` seconds of scrolling.
+ */
+void world_scroll_pipes(World *world, float dt);
+
+/**
+ * Set the leftmost pipe back to the far right once it is off screen.
+ */
+void world_recycle_pipes(World *world);
+
+#endif // FLAP_WORLD_INTERNAL_H